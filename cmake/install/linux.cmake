@@ -18,6 +18,6 @@
 #
 
 if(${CMAKE_SYSTEM_NAME} STREQUAL "Linux")
-    install(TARGETS falltergeist-bin RUNTIME DESTINATION bin)
+    install(TARGETS falltergeist-bin falltergeist-packer RUNTIME DESTINATION bin)
     install(DIRECTORY data DESTINATION share/falltergeist)
 endif()
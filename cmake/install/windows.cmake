@@ -18,7 +18,7 @@
 #
 
 if(WIN32)
-    install(TARGETS falltergeist-bin RUNTIME DESTINATION .)
+    install(TARGETS falltergeist-bin falltergeist-packer RUNTIME DESTINATION .)
     install(DIRECTORY data DESTINATION .)
 
     #MinGW runtime
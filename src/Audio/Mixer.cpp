@@ -26,6 +26,7 @@
 // Falltergeist includes
 #include "../Exception.h"
 #include "../Logger.h"
+#include "../Profiler.h"
 #include "../UI/MvePlayer.h"
 #include "../Game/Game.h"
 #include "../ResourceManager.h"
@@ -40,6 +41,18 @@ namespace Falltergeist
 namespace Audio
 {
 
+namespace
+{
+// Callbacks run on SDL audio thread, which is named once the profiler is on
+void nameAudioThread()
+{
+    thread_local bool named = false;
+    if (named || !Profiler::enabled()) return;
+    Profiler::setThreadName("audio");
+    named = true;
+}
+}
+
 Mixer::Mixer()
 {
     _init();
@@ -88,6 +101,8 @@ void myMusicPlayer(void *udata, uint8_t *stream, int len)
 
 void Mixer::_musicCallback(void *udata, uint8_t *stream, uint32_t len)
 {
+    nameAudioThread();
+    FALLTERGEIST_PROFILE("Mixer::musicCallback");
     if (_paused) return;
 
     auto pacm = (libfalltergeist::Acm::File*)(udata);
@@ -138,6 +153,8 @@ void Mixer::playACMMusic(const std::string& filename, bool loop)
 
 void Mixer::_movieCallback(void *udata, uint8_t *stream, uint32_t len)
 {
+    nameAudioThread();
+    FALLTERGEIST_PROFILE("Mixer::movieCallback");
     auto pmve = (UI::MvePlayer*)(udata);
     if (pmve->samplesLeft() <= 0)
     {
@@ -22,6 +22,8 @@
 // Falltergeist includes
 #include "Base/StlFeatures.h"
 #include "Font.h"
+#include "Game/Game.h"
+#include "Graphics/Renderer.h"
 #include "ResourceManager.h"
 
 // Third party includes
@@ -30,41 +32,60 @@ namespace Falltergeist
 {
 using Base::make_unique;
 
-Font::Font(const std::string& filename, unsigned int color)
+Font::Font(const std::string& filename, unsigned int color, Graphics::Texture* texture)
 {
     _filename = filename;
     _aaf = ResourceManager::getInstance()->aafFileType(filename);
     _color = color;
+    _texture = texture;
+}
 
-    unsigned int width = _aaf->maximumWidth()*16u;
-    unsigned int height = _aaf->maximumHeight()*16u;
+Font::~Font()
+{
+}
 
-    unsigned int rgba[width * height];
+std::unique_ptr<Graphics::Texture> Font::createTexture(libfalltergeist::Aaf::File* aaf)
+{
+    unsigned int width = aaf->maximumWidth()*16u;
+    unsigned int height = aaf->maximumHeight()*16u;
 
-    for (unsigned int y = 0; y != height; y++)
+    std::vector<unsigned int> rgba(width * height);
+    for (unsigned int i = 0; i != width * height; ++i)
     {
-        for (unsigned int x = 0; x != width; x++)
-        {
-            unsigned int index = y * width + x;
-            unsigned char alpha = _aaf->rgba()[index];
-            //if (alpha > 0) alpha = 0xff;
-            rgba[index] = (color & 0xFFFFFF00) | alpha;
-        }
+        rgba[i] = 0xFFFFFF00 | aaf->rgba()[i];
     }
 
-    _texture = make_unique<Graphics::Texture>(width, height);
-    _texture->loadFromRGBA(rgba);
+    auto texture = make_unique<Graphics::Texture>(width, height);
+    texture->loadFromRGBA(rgba.data());
+    return texture;
 }
 
-Font::~Font()
+unsigned int Font::color()
 {
+    return _color;
 }
 
-unsigned int Font::color()
+SDL_Color Font::_sdlColor()
 {
-    return _color;
+    SDL_Color color = {(Uint8)(_color >> 24), (Uint8)(_color >> 16), (Uint8)(_color >> 8), 0xFF};
+    return color;
 }
 
+void Font::renderGlyph(unsigned char chr, int x, int y)
+{
+    // Renderer takes color modifier when draw is queued, so one texture serves all colors in a frame
+    _texture->setColorModifier(_sdlColor());
+    Game::getInstance()->renderer()->drawTexture(_texture, x, y, (chr % 16) * width(), (chr / 16) * height(), width(), height());
+}
+
+void Font::copyGlyphTo(unsigned char chr, Graphics::Texture* destination, unsigned int x, unsigned int y)
+{
+    auto color = _sdlColor();
+    auto surface = _texture->sdlSurface();
+    SDL_SetSurfaceColorMod(surface, color.r, color.g, color.b);
+    _texture->copyTo(destination, x, y, (chr % 16) * width(), (chr / 16) * height(), width(), height());
+    SDL_SetSurfaceColorMod(surface, 0xFF, 0xFF, 0xFF);
+}
 unsigned short Font::height()
 {
     return _aaf->maximumHeight();
@@ -92,7 +113,7 @@ unsigned short Font::spaceWidth()
 
 Graphics::Texture* Font::texture()
 {
-    return _texture.get();
+    return _texture;
 }
 
 std::string Font::filename() const
@@ -38,9 +38,18 @@ namespace Falltergeist
 class Font
 {
 public:
-    Font(const std::string& filename, unsigned int color);
+    /**
+     * Font of given color drawn from given glyph atlas. Atlas is shared by all colors of the font
+     * and holds white glyphs, color is applied when they are drawn.
+     */
+    Font(const std::string& filename, unsigned int color, Graphics::Texture* texture);
     ~Font();
 
+    /**
+     * Creates white glyph atlas of given AAF font, 16x16 cells of maximum glyph size.
+     */
+    static std::unique_ptr<Graphics::Texture> createTexture(libfalltergeist::Aaf::File* aaf);
+
     unsigned int color();
 
     unsigned short horizontalGap();
@@ -58,12 +67,24 @@ public:
 
     libfalltergeist::Aaf::File* aaf();
 
+    /**
+     * Draws glyph in font color on screen.
+     */
+    void renderGlyph(unsigned char chr, int x, int y);
+    /**
+     * Blends glyph in font color into given texture.
+     */
+    void copyGlyphTo(unsigned char chr, Graphics::Texture* destination, unsigned int x, unsigned int y);
+
 protected:
     unsigned int _color = 0;
     libfalltergeist::Aaf::File* _aaf = nullptr;
-    std::unique_ptr<Graphics::Texture> _texture = nullptr;
+    // Owned by ResourceManager
+    Graphics::Texture* _texture = nullptr;
     std::string _filename;
 
+    SDL_Color _sdlColor();
+
 };
 
 }
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Related headers
+#include "../Game/Clock.h"
+
+// C++ standard includes
+
+// Falltergeist includes
+
+// Third party includes
+#include "SDL.h"
+
+namespace Falltergeist
+{
+namespace Game
+{
+
+const unsigned int Clock::TIMESTEP = 10;
+const unsigned int Clock::MAX_STEPS = 25;
+const unsigned int Clock::NEVER = std::numeric_limits<unsigned int>::max();
+
+Clock::Clock()
+{
+    _frequency = SDL_GetPerformanceFrequency();
+    _lastCounter = SDL_GetPerformanceCounter();
+    _ticks = SDL_GetTicks();
+}
+
+Clock::~Clock()
+{
+}
+
+void Clock::beginFrame()
+{
+    uint64_t counter = SDL_GetPerformanceCounter();
+    _backlog += (counter - _lastCounter) * 1000.0 / _frequency;
+    _lastCounter = counter;
+    _steps = 0;
+
+    // Loading a location or a window drag may take seconds, they are not caught up with
+    if (_backlog > TIMESTEP * MAX_STEPS)
+    {
+        _backlog = TIMESTEP * MAX_STEPS;
+    }
+}
+
+bool Clock::step()
+{
+    if (_backlog < TIMESTEP || _steps >= MAX_STEPS) return false;
+
+    _backlog -= TIMESTEP;
+    _ticks += TIMESTEP;
+    _steps++;
+    return true;
+}
+
+unsigned int Clock::ticks() const
+{
+    return _ticks;
+}
+
+unsigned int Clock::delta() const
+{
+    return TIMESTEP;
+}
+
+double Clock::alpha() const
+{
+    return _backlog < TIMESTEP ? _backlog / TIMESTEP : 1.0;
+}
+
+unsigned int Clock::timeUntil(unsigned int ticks) const
+{
+    if (ticks == NEVER) return NEVER;
+
+    double backlog = _backlog + (SDL_GetPerformanceCounter() - _lastCounter) * 1000.0 / _frequency;
+    double time = (double)ticks - _ticks - backlog;
+    return time > 0 ? (unsigned int)time : 0;
+}
+
+unsigned int Clock::frameCap() const
+{
+    return _frameCap;
+}
+
+void Clock::setFrameCap(unsigned int frameCap)
+{
+    _frameCap = frameCap;
+    _frameDuration = frameCap ? _frequency / frameCap : 0;
+    _nextFrame = 0;
+}
+
+void Clock::waitForNextFrame()
+{
+    if (!_frameDuration) return;
+
+    uint64_t counter = SDL_GetPerformanceCounter();
+    // Deadlines follow each other, so late frames don't make the frame rate drift
+    _nextFrame += _frameDuration;
+    if (_nextFrame < counter)
+    {
+        _nextFrame = counter;
+        return;
+    }
+
+    // SDL_Delay may oversleep by a millisecond or so, the last one is spun
+    uint64_t margin = _frequency / 1000;
+    while (counter < _nextFrame)
+    {
+        uint64_t remaining = _nextFrame - counter;
+        if (remaining > 2 * margin)
+        {
+            SDL_Delay((remaining - margin) * 1000 / _frequency);
+        }
+        counter = SDL_GetPerformanceCounter();
+    }
+}
+
+}
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FALLTERGEIST_GAME_CLOCK_H
+#define FALLTERGEIST_GAME_CLOCK_H
+
+// C++ standard includes
+#include <cstdint>
+#include <limits>
+
+// Falltergeist includes
+
+// Third party includes
+
+namespace Falltergeist
+{
+namespace Game
+{
+
+/**
+ * @brief Timing of the main loop.
+ * Game logic advances in fixed steps of TIMESTEP milliseconds, as many as real time passed since previous frame,
+ * so it runs at the same pace at any frame rate. Frames are paced by frame cap.
+ */
+class Clock
+{
+public:
+    // Milliseconds of simulation time in one step
+    static const unsigned int TIMESTEP;
+    // Steps per frame, backlog above it is dropped and the game slows down instead of stalling
+    static const unsigned int MAX_STEPS;
+    // Wake-up time of things that change on input only
+    static const unsigned int NEVER;
+
+    Clock();
+    ~Clock();
+
+    /**
+     * Adds real time passed since previous frame to the backlog of simulation time.
+     */
+    void beginFrame();
+    /**
+     * Takes one step from the backlog and advances simulation time. Returns false when there is nothing to take.
+     */
+    bool step();
+    /**
+     * Simulation time in milliseconds. Game logic uses it instead of SDL_GetTicks().
+     */
+    unsigned int ticks() const;
+    /**
+     * Simulation time advanced with current step.
+     */
+    unsigned int delta() const;
+    /**
+     * Part of a step left in the backlog, from 0 to 1. Rendering interpolates between the last two steps with it.
+     */
+    double alpha() const;
+    /**
+     * Real time in milliseconds left until simulation reaches given time, 0 when it is due already.
+     */
+    unsigned int timeUntil(unsigned int ticks) const;
+
+    unsigned int frameCap() const;
+    /**
+     * Limits frames per second, 0 means no limit.
+     */
+    void setFrameCap(unsigned int frameCap);
+    /**
+     * Sleeps until the next frame is due according to frame cap.
+     */
+    void waitForNextFrame();
+
+protected:
+    uint64_t _frequency;
+    uint64_t _lastCounter;
+    uint64_t _nextFrame = 0;
+    uint64_t _frameDuration = 0;
+    unsigned int _frameCap = 0;
+    // Milliseconds
+    double _backlog = 0;
+    unsigned int _ticks;
+    unsigned int _steps = 0;
+};
+
+}
+}
+#endif // FALLTERGEIST_GAME_CLOCK_H
@@ -28,6 +28,7 @@
 #include "../Exception.h"
 #include "../Game/Defines.h"
 #include "../Game/DudeObject.h"
+#include "../Game/Clock.h"
 #include "../Game/Game.h"
 #include "../Game/WeaponItemObject.h"
 #include "../Logger.h"
@@ -498,7 +499,7 @@ void CritterObject::think()
         auto anim = (UI::Animation*)ui();
         if (!_moving && (!anim || !anim->playing()))
         {
-            if (SDL_GetTicks() > _nextIdleAnim)
+            if (Game::getInstance()->clock()->ticks() > _nextIdleAnim)
             {
                 setActionAnimation("aa");
                 _setupNextIdleAnim();
@@ -726,7 +727,7 @@ void CritterObject::stopMovement()
 
 void CritterObject::_setupNextIdleAnim()
 {
-    _nextIdleAnim = SDL_GetTicks() + 10000 + (rand() % 7000);
+    _nextIdleAnim = Game::getInstance()->clock()->ticks() + 10000 + (rand() % 7000);
 }
 
 unsigned CritterObject::age() const
@@ -31,6 +31,7 @@
 #include "../Event/Dispatcher.h"
 #include "../Event/State.h"
 #include "../Exception.h"
+#include "../Game/Clock.h"
 #include "../Game/DudeObject.h"
 #include "../Game/Time.h"
 #include "../Graphics/AnimatedPalette.h"
@@ -38,11 +39,14 @@
 #include "../Input/Mouse.h"
 #include "../Logger.h"
 #include "../Lua/Script.h"
+#include "../Profiler.h"
 #include "../ResourceManager.h"
 #include "../Settings.h"
 #include "../State/State.h"
 #include "../State/Location.h"
 #include "../UI/FpsCounter.h"
+#include "../UI/ProfilerCounter.h"
+#include "../UI/ResourceCounter.h"
 #include "../UI/TextArea.h"
 
 // Third patry includes
@@ -88,6 +92,8 @@ void Game::init(std::unique_ptr<Settings> settings)
 
     // Force ResourceManager to initialize instance.
     (void)ResourceManager::getInstance();
+    // Resources used by previous session are loaded while intro and main menu are shown
+    ResourceManager::getInstance()->prewarm();
 
     renderer()->init();
 
@@ -97,6 +103,8 @@ void Game::init(std::unique_ptr<Settings> settings)
     _mixer = make_unique<Audio::Mixer>();
     _mouse = make_unique<Input::Mouse>();
     _fpsCounter = make_unique<UI::FpsCounter>(renderer()->width() - 42, 2);
+    _resourceCounter = make_unique<UI::ResourceCounter>(renderer()->width() - 262, 2);
+    _profilerCounter = make_unique<UI::ProfilerCounter>(3, 2);
 
     version += " " + to_string(renderer()->size());
     version += " " + renderer()->name();
@@ -117,8 +125,10 @@ Game::~Game()
 void Game::shutdown()
 {
     _mixer.reset();
-    ResourceManager::getInstance()->shutdown();
+    // States may point to textures and fonts, which are freed by ResourceManager::shutdown()
     while (!_states.empty()) popState();
+    _statesForDelete.clear();
+    ResourceManager::getInstance()->shutdown();
     _settings.reset();
 }
 
@@ -128,6 +138,7 @@ void Game::pushState(State::State* state)
     if (!state->initialized()) state->init();
     state->setActive(true);
     state->emitEvent(make_unique<Event::State>("activate"));
+    invalidate();
 }
 
 void Game::popState()
@@ -139,6 +150,7 @@ void Game::popState()
     _states.pop_back();
     state->setActive(false);
     state->emitEvent(make_unique<Event::State>("deactivate"));
+    invalidate();
 }
 
 void Game::setState(State::State* state)
@@ -151,18 +163,98 @@ void Game::run()
 {
     Logger::info("GAME") << "Starting main loop" << std::endl;
     _frame = 0;
+    _clock.setFrameCap(_frameCap());
+    if (_clock.frameCap())
+    {
+        Logger::info("GAME") << "Frame cap: " << _clock.frameCap() << " fps" << std::endl;
+    }
+    Profiler::setThreadName("main");
+    Profiler::setEnabled(_settings->displayProfiler());
     while (!_quit)
     {
+        _clock.beginFrame();
         handle();
-        think();
-        render();
-        SDL_Delay(1);
+        // Logic catches up with real time in fixed steps, rendering interpolates between the last two of them
+        unsigned int steps = 0;
+        while (_clock.step())
+        {
+            think();
+            steps++;
+        }
+        _thinkFrame();
+
+        // Something scheduled by the states happened since previous frame
+        if (_clock.ticks() >= _wakeUp)
+        {
+            invalidate();
+        }
+        _wakeUp = _nextWakeUp();
+
+        if (_invalidated)
+        {
+            render();
+            _frame++;
+            // Passes that only wait for events are counted into the next rendered frame
+            Profiler::beginFrame();
+            // Changes made on input are shown once a step has processed them
+            if (steps > 0)
+            {
+                _invalidated = false;
+            }
+            _clock.waitForNextFrame();
+        }
         _statesForDelete.clear();
-        _frame++;
+
+        if (!_invalidated)
+        {
+            _waitForEvents();
+        }
     }
     Logger::info("GAME") << "Stopping main loop" << std::endl;
 }
 
+void Game::invalidate()
+{
+    _invalidated = true;
+}
+
+unsigned int Game::_nextWakeUp()
+{
+    auto wakeUp = _renderer->nextWakeUp();
+    if (_mouse->ui())
+    {
+        wakeUp = std::min(wakeUp, _mouse->ui()->nextWakeUp());
+    }
+    for (auto state : _getActiveStates())
+    {
+        wakeUp = std::min(wakeUp, state->nextWakeUp());
+    }
+    if (settings()->displayResourceStatistics())
+    {
+        wakeUp = std::min(wakeUp, _resourceCounter->nextWakeUp());
+    }
+    if (Profiler::enabled())
+    {
+        wakeUp = std::min(wakeUp, _profilerCounter->nextWakeUp());
+    }
+    return wakeUp;
+}
+
+void Game::_waitForEvents()
+{
+    // Clock catches up with up to MAX_STEPS, sleeping longer would slow the game down
+    unsigned int timeout = std::min(_clock.timeUntil(_wakeUp), Clock::TIMESTEP * (Clock::MAX_STEPS - 1));
+    // Prewarmed resources are taken over a few per frame
+    if (ResourceManager::getInstance()->updatePending())
+    {
+        timeout = std::min(timeout, Clock::TIMESTEP);
+    }
+    if (timeout == 0) return;
+
+    // Event is left in the queue for handle()
+    SDL_WaitEventTimeout(nullptr, timeout);
+}
+
 void Game::quit()
 {
     _quit = true;
@@ -339,6 +431,21 @@ std::unique_ptr<Event::Event> Game::_createEventFromSDL(const SDL_Event& sdlEven
             keyboardEvent->setControlPressed(sdlEvent.key.keysym.mod & KMOD_CTRL);;
 
             // TODO: maybe we should make Game an EventTarget too?
+            // Ctrl+F11 switches profiler on and off, F11 saves what it has recorded
+            if (keyboardEvent->keyCode() == SDLK_F11 && keyboardEvent->controlPressed())
+            {
+                Profiler::setEnabled(!Profiler::enabled());
+                Logger::info("GAME") << "Profiler " << (Profiler::enabled() ? "enabled" : "disabled") << std::endl;
+            }
+            else if (keyboardEvent->keyCode() == SDLK_F11)
+            {
+                std::string name = "trace-" + std::to_string(SDL_GetTicks()) + ".json";
+                if (Profiler::saveTrace(name))
+                {
+                    Logger::info("GAME") << "Profiler trace saved to " + name << std::endl;
+                }
+            }
+
             if (keyboardEvent->keyCode() == SDLK_F12)
             {
                 auto texture = renderer()->screenshot();
@@ -354,14 +461,20 @@ std::unique_ptr<Event::Event> Game::_createEventFromSDL(const SDL_Event& sdlEven
 
 void Game::handle()
 {
+    FALLTERGEIST_PROFILE("Game::handle");
     if (_renderer->fading()) return;
 
     while (SDL_PollEvent(&_event))
     {
+        invalidate();
         if (_event.type == SDL_QUIT)
         {
             _quit = true;
         }
+        else if (_event.type == SDL_RENDER_TARGETS_RESET || _event.type == SDL_RENDER_DEVICE_RESET)
+        {
+            _renderer->invalidateCaches();
+        }
         else
         {
             auto event = _createEventFromSDL(_event);
@@ -377,17 +490,10 @@ void Game::handle()
 
 void Game::think()
 {
-    _fpsCounter->think();
+    FALLTERGEIST_PROFILE("Game::think");
     _mouse->think();
-
     _animatedPalette->think();
-
-    *_mousePosition = "";
-    *_mousePosition << mouse()->position().x() << " : " << mouse()->position().y();
-
-    *_currentTime = "";
-    *_currentTime << _gameTime.year()  << "-" << _gameTime.month()   << "-" << _gameTime.day() << " "
-                  << _gameTime.hours() << ":" << _gameTime.minutes() << ":" << _gameTime.seconds() << " " << _gameTime.ticks();
+    _renderer->think();
 
     if (_renderer->fading())
     {
@@ -402,13 +508,65 @@ void Game::think()
     _eventDispatcher->processScheduledEvents();
 }
 
+void Game::_thinkFrame()
+{
+    if (settings()->displayResourceStatistics())
+    {
+        _resourceCounter->think();
+    }
+
+    if (Profiler::enabled())
+    {
+        _profilerCounter->think();
+    }
+
+    ResourceManager::getInstance()->update();
+
+    // Has time budget of its own, which is spent once per frame rather than on every step catching up
+    if (auto location = locationState())
+    {
+        location->thinkFrame();
+    }
+
+    // Texts are laid out again only when they change
+    _mousePosition->setText(std::to_string(mouse()->position().x()) + " : " + std::to_string(mouse()->position().y()));
+    _currentTime->setText(std::to_string(_gameTime.year()) + "-" + std::to_string(_gameTime.month()) + "-" + std::to_string(_gameTime.day()) + " "
+                          + std::to_string(_gameTime.hours()) + ":" + std::to_string(_gameTime.minutes()) + ":" + std::to_string(_gameTime.seconds())
+                          + " " + std::to_string(_gameTime.ticks()));
+}
+
+unsigned int Game::_frameCap()
+{
+    if (_settings->frameCap())
+    {
+        return _settings->frameCap();
+    }
+    // Presenting waits for the display already, otherwise frames are limited to what the display can show
+    if (_renderer->vsync())
+    {
+        return 0;
+    }
+    return _renderer->refreshRate();
+}
+
 void Game::render()
 {
+    FALLTERGEIST_PROFILE("Game::render");
+    // Counts rendered frames only
+    _fpsCounter->think();
     renderer()->beginFrame();
 
     for (auto state : _getVisibleStates())
     {
-        state->render();
+        // States under a modal one don't change, they are drawn from snapshots
+        if (state->active())
+        {
+            state->render();
+        }
+        else
+        {
+            state->renderSnapshot();
+        }
     }
 
     if (settings()->displayFps())
@@ -416,6 +574,16 @@ void Game::render()
         _fpsCounter->render();
     }
 
+    if (settings()->displayResourceStatistics())
+    {
+        _resourceCounter->render();
+    }
+
+    if (Profiler::enabled())
+    {
+        _profilerCounter->render();
+    }
+
     _falltergeistVersion->render();
 
     if (settings()->displayMousePosition())
@@ -433,6 +601,11 @@ Graphics::AnimatedPalette* Game::animatedPalette()
     return _animatedPalette.get();
 }
 
+Clock* Game::clock()
+{
+    return &_clock;
+}
+
 Time* Game::gameTime()
 {
     return &_gameTime;
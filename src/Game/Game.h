@@ -28,6 +28,7 @@
 
 // Falltergeist includes
 #include "../Base/Singleton.h"
+#include "../Game/Clock.h"
 #include "../Game/Time.h"
 
 // Third party includes
@@ -64,6 +65,8 @@ namespace State
 namespace UI
 {
     class FpsCounter;
+    class ProfilerCounter;
+    class ResourceCounter;
     class TextArea;
 }
 class Exception;
@@ -90,6 +93,10 @@ public:
     void popState();
     void run();
     void quit();
+    /**
+     * Makes the main loop render next frame. Input, state changes and wake-ups of active states do it already.
+     */
+    void invalidate();
     void init(std::unique_ptr<Settings> settings);
 
     /**
@@ -97,7 +104,7 @@ public:
      */
     void handle();
     /**
-     * @brief Process real-time logic.
+     * @brief Process real-time logic for one step of the clock.
      */
     void think();
     /**
@@ -110,6 +117,7 @@ public:
     Input::Mouse* mouse() const;
     Graphics::Renderer* renderer();
     Time* gameTime();
+    Clock* clock();
     State::Location* locationState();
     Audio::Mixer* mixer();
     Event::Dispatcher* eventDispatcher();
@@ -128,6 +136,7 @@ protected:
     std::vector<std::unique_ptr<State::State>> _statesForDelete;
 
     Time _gameTime;
+    Clock _clock;
 
     unsigned int _frame = 0;
 
@@ -139,15 +148,31 @@ protected:
     std::unique_ptr<Event::Dispatcher> _eventDispatcher;
 
     std::unique_ptr<UI::FpsCounter> _fpsCounter;
+    std::unique_ptr<UI::ResourceCounter> _resourceCounter;
+    std::unique_ptr<UI::ProfilerCounter> _profilerCounter;
     std::unique_ptr<UI::TextArea> _mousePosition, _currentTime, _falltergeistVersion;
 
     std::unique_ptr<DudeObject> _player;
 
     bool _quit = false;
+    // Whether screen needs rendering, main loop sleeps otherwise
+    bool _invalidated = true;
+    // Earliest wake-up of active states, in simulation time
+    unsigned int _wakeUp = 0;
     bool _initialized = false;
 
     SDL_Event _event;
 
+    /**
+     * Per frame work that is not part of the simulation: counters, debug overlays and resource streaming.
+     */
+    void _thinkFrame();
+    unsigned int _frameCap();
+    unsigned int _nextWakeUp();
+    /**
+     * Sleeps until input arrives or the next wake-up is due.
+     */
+    void _waitForEvents();
     std::vector<State::State*> _getVisibleStates();
     std::vector<State::State*> _getActiveStates();
 
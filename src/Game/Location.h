@@ -70,7 +70,7 @@ public:
 
     std::map<unsigned int, unsigned int>* startPoints();
 
-    std::vector<Game::LocationElevation*>* elevations();
+    std::vector<LocationElevation*>* elevations();
 
 protected:
     /**
@@ -130,7 +130,7 @@ protected:
     /**
      * @brief Map elevations
      */
-    std::vector<Game::LocationElevation*> _elevations;
+    std::vector<LocationElevation*> _elevations;
 };
 
 }
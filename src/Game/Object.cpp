@@ -30,6 +30,7 @@
 #include "../Game/CritterObject.h"
 #include "../Game/Defines.h"
 #include "../Game/DudeObject.h"
+#include "../Game/Clock.h"
 #include "../Game/Game.h"
 #include "../LocationCamera.h"
 #include "../Logger.h"
@@ -194,6 +195,12 @@ void Object::_generateUi()
     }
 
     addUIEventHandlers();
+
+    // E.g. armor changed in inventory, location under it is drawn from snapshot
+    if (auto location = Game::getInstance()->locationState())
+    {
+        location->invalidateSnapshot();
+    }
 }
 
 bool Object::canWalkThru() const
@@ -270,7 +277,7 @@ void Object::renderText()
 {
     if (auto message = floatMessage())
     {
-        if (SDL_GetTicks() - message->timestampCreated() >= 7000)
+        if (Game::getInstance()->clock()->ticks() - message->timestampCreated() >= 7000)
         {
             setFloatMessage(nullptr);
         }
@@ -23,9 +23,10 @@
 // C++ standard includes
 
 // Falltergeist includes
+#include "../Game/Clock.h"
+#include "../Game/Game.h"
 
 // Third party includes
-#include "SDL.h"
 
 namespace Falltergeist
 {
@@ -42,8 +43,10 @@ Time::~Time()
 
 void Time::think()
 {
-    if (SDL_GetTicks() - _timer < 100) return;
-    _timer = SDL_GetTicks();
+    // Game time tick is 100 ms of simulation time
+    _timer += Game::getInstance()->clock()->delta();
+    if (_timer < 100) return;
+    _timer -= 100;
     increaseTicks();
 }
 
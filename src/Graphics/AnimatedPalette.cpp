@@ -21,10 +21,16 @@
 #include "../Graphics/AnimatedPalette.h"
 
 // C++ standard includes
+#include <algorithm>
 
 // Falltergeist includes
+#include "../Base/StlFeatures.h"
+#include "../Game/Clock.h"
+#include "../Game/Game.h"
+#include "../Graphics/PaletteOverlay.h"
 
 // Third party includes
+#include <libfalltergeist/Frm/File.h>
 #include <SDL.h>
 
 
@@ -123,49 +129,57 @@ unsigned int AnimatedPalette::color(unsigned char index, unsigned char counter)
 
 void AnimatedPalette::think()
 {
-    if (_monitorsTicks + 100 < SDL_GetTicks())
+    auto delta = Game::getInstance()->clock()->delta();
+
+    _monitorsTime += delta;
+    if (_monitorsTime >= 100)
     {
-        _monitorsTicks = SDL_GetTicks();
+        _monitorsTime -= 100;
 
         _monitorsCounter++;
         if (_monitorsCounter >= 5) _monitorsCounter = 0;
     }
 
-    if (_slimeTicks + 200 < SDL_GetTicks())
+    _slimeTime += delta;
+    if (_slimeTime >= 200)
     {
-        _slimeTicks = SDL_GetTicks();
+        _slimeTime -= 200;
 
         _slimeCounter++;
         if (_slimeCounter >= 4) _slimeCounter = 0;
     }
 
-    if (_shoreTicks + 200 < SDL_GetTicks())
+    _shoreTime += delta;
+    if (_shoreTime >= 200)
     {
-        _shoreTicks = SDL_GetTicks();
+        _shoreTime -= 200;
 
         _shoreCounter++;
-        if (_shoreCounter >= 6) _slimeCounter = 0;
+        if (_shoreCounter >= 6) _shoreCounter = 0;
     }
 
-    if (_fireSlowTicks + 200 < SDL_GetTicks())
+    _fireSlowTime += delta;
+    if (_fireSlowTime >= 200)
     {
-        _fireSlowTicks = SDL_GetTicks();
+        _fireSlowTime -= 200;
 
         _fireSlowCounter++;
         if (_fireSlowCounter >= 5) _fireSlowCounter = 0;
     }
 
-    if (_fireFastTicks + 142 < SDL_GetTicks())
+    _fireFastTime += delta;
+    if (_fireFastTime >= 142)
     {
-        _fireFastTicks = SDL_GetTicks();
+        _fireFastTime -= 142;
 
         _fireFastCounter++;
         if (_fireFastCounter >= 5) _fireFastCounter = 0;
     }
 
-    if (_blinkingRedTicks + 33 < SDL_GetTicks())
+    _blinkingRedTime += delta;
+    if (_blinkingRedTime >= 33)
     {
-        _blinkingRedTicks = SDL_GetTicks();
+        _blinkingRedTime -= 33;
 
         if ((_blinkingRedCounter == 0) || (_blinkingRedCounter == 15))
         {
@@ -176,6 +190,13 @@ void AnimatedPalette::think()
     }
 }
 
+unsigned int AnimatedPalette::nextWakeUp() const
+{
+    unsigned int delay = std::min({100 - _monitorsTime, 200 - _slimeTime, 200 - _shoreTime,
+                                   200 - _fireSlowTime, 142 - _fireFastTime, 33 - _blinkingRedTime});
+    return Game::getInstance()->clock()->ticks() + delay;
+}
+
 unsigned int AnimatedPalette::getCounter(MASK type)
 {
     switch (type)
@@ -196,5 +217,15 @@ unsigned int AnimatedPalette::getCounter(MASK type)
     return 0;
 }
 
+PaletteOverlay* AnimatedPalette::overlay(libfalltergeist::Frm::File* frm)
+{
+    auto it = _overlays.find(frm->filename());
+    if (it == _overlays.end())
+    {
+        it = _overlays.insert(std::make_pair(frm->filename(), Base::make_unique<PaletteOverlay>(frm, this))).first;
+    }
+    return it->second->empty() ? nullptr : it->second.get();
+}
+
 }
 }
@@ -22,17 +22,27 @@
 
 // C++ standard includes
 #include <array>
+#include <memory>
+#include <string>
+#include <unordered_map>
 
 // Falltergeist includes
 
 // Third party includes
 #include <libfalltergeist/Enums.h>
 
+namespace libfalltergeist
+{
+namespace Frm { class File; }
+}
+
 namespace Falltergeist
 {
 namespace Graphics
 {
 
+class PaletteOverlay;
+
 class AnimatedPalette
 {
 public:
@@ -42,6 +52,14 @@ public:
     unsigned int color(unsigned char index, unsigned char counter);
     void think();
     unsigned int getCounter(MASK type);
+    /**
+     * Shared overlay with animated pixels of given FRM, nullptr if it has none.
+     */
+    PaletteOverlay* overlay(libfalltergeist::Frm::File* frm);
+    /**
+     * Simulation time when the next color cycle changes.
+     */
+    unsigned int nextWakeUp() const;
 
 protected:
     static const std::array<unsigned int, 5> _monitorsPalette;
@@ -50,19 +68,21 @@ protected:
     static const std::array<unsigned int, 5> _fireSlowPalette;
     static const std::array<unsigned int, 5> _fireFastPalette;
 
-    unsigned int _slimeTicks = 0;
+    unsigned int _slimeTime = 0;
     unsigned int _slimeCounter = 0;
-    unsigned int _fireSlowTicks = 0;
+    unsigned int _fireSlowTime = 0;
     unsigned int _fireSlowCounter = 0;
-    unsigned int _fireFastTicks = 0;
+    unsigned int _fireFastTime = 0;
     unsigned int _fireFastCounter = 0;
-    unsigned int _monitorsTicks = 0;
+    unsigned int _monitorsTime = 0;
     unsigned int _monitorsCounter = 0;
-    unsigned int _shoreTicks = 0;
+    unsigned int _shoreTime = 0;
     unsigned int _shoreCounter = 0;
-    unsigned int _blinkingRedTicks = 0;
+    unsigned int _blinkingRedTime = 0;
     unsigned char _blinkingRedCounter = 0;
     short _blinkingRed = -1;
+
+    std::unordered_map<std::string, std::unique_ptr<PaletteOverlay>> _overlays;
 };
 
 }
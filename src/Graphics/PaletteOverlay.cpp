@@ -0,0 +1,173 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Related headers
+#include "../Graphics/PaletteOverlay.h"
+
+// C++ standard includes
+#include <algorithm>
+#include <climits>
+
+// Falltergeist includes
+#include "../Base/StlFeatures.h"
+#include "../Game/Game.h"
+#include "../Graphics/AnimatedPalette.h"
+#include "../Graphics/Renderer.h"
+#include "../Graphics/Texture.h"
+
+// Third party includes
+#include <libfalltergeist/Frm/File.h>
+#include <SDL.h>
+
+namespace Falltergeist
+{
+namespace Graphics
+{
+
+using namespace Base;
+
+PaletteOverlay::PaletteOverlay(libfalltergeist::Frm::File* frm, AnimatedPalette* palette) : _palette(palette)
+{
+    _size = Size(frm->width(), frm->height());
+    auto masks = frm->animatedMasks();
+
+    int left = INT_MAX, top = INT_MAX, right = -1, bottom = -1;
+    for (auto type : {MASK::FIRE_FAST, MASK::FIRE_SLOW, MASK::SLIME, MASK::SHORE, MASK::MONITOR, MASK::REDDOT})
+    {
+        auto mask = masks->find(type);
+        if (mask == masks->end() || !mask->second) continue;
+
+        Layer layer;
+        layer.type = type;
+        layer.counter = UINT_MAX;
+        for (int y = 0; y != _size.height(); ++y)
+        {
+            for (int x = 0; x != _size.width(); ++x)
+            {
+                unsigned int offset = y * _size.width() + x;
+                if (!mask->second[offset]) continue;
+
+                // Offsets are relative to FRM texture until bounding box is known
+                layer.pixels.push_back({offset, mask->second[offset]});
+                left = std::min(left, x);
+                top = std::min(top, y);
+                right = std::max(right, x);
+                bottom = std::max(bottom, y);
+            }
+        }
+        if (!layer.pixels.empty()) _layers.push_back(std::move(layer));
+    }
+
+    if (_layers.empty()) return;
+
+    _position = Point(left, top);
+    unsigned int width = right - left + 1;
+    unsigned int height = bottom - top + 1;
+    for (auto& layer : _layers)
+    {
+        int layerLeft = INT_MAX, layerTop = INT_MAX, layerRight = -1, layerBottom = -1;
+        for (auto& pixel : layer.pixels)
+        {
+            int x = pixel.offset % _size.width() - left;
+            int y = pixel.offset / _size.width() - top;
+            pixel.offset = y * width + x;
+            layerLeft = std::min(layerLeft, x);
+            layerTop = std::min(layerTop, y);
+            layerRight = std::max(layerRight, x);
+            layerBottom = std::max(layerBottom, y);
+        }
+        layer.bounds = {layerLeft, layerTop, layerRight - layerLeft + 1, layerBottom - layerTop + 1};
+        layer.pixels.shrink_to_fit();
+    }
+    _texture = make_unique<Texture>(width, height);
+}
+
+PaletteOverlay::~PaletteOverlay()
+{
+}
+
+bool PaletteOverlay::empty() const
+{
+    return _layers.empty();
+}
+
+void PaletteOverlay::_update()
+{
+    SDL_Surface* surface = _texture->sdlSurface();
+
+    if (SDL_MUSTLOCK(surface))
+    {
+        SDL_LockSurface(surface);
+    }
+
+    unsigned int* pixels = (unsigned int*)surface->pixels;
+    for (auto& layer : _layers)
+    {
+        unsigned int counter = _palette->getCounter(layer.type);
+        if (counter == layer.counter) continue;
+
+        layer.counter = counter;
+        for (auto& pixel : layer.pixels)
+        {
+            pixels[pixel.offset] = _palette->color(pixel.index, counter);
+        }
+        _texture->update(layer.bounds);
+    }
+
+    if (SDL_MUSTLOCK(surface))
+    {
+        SDL_UnlockSurface(surface);
+    }
+}
+
+void PaletteOverlay::render(const Point& position, const Point& source, const Size& sourceSize)
+{
+    if (!_texture) return;
+
+    SDL_Rect sourceRect = {source.x(), source.y(), sourceSize.width(), sourceSize.height()};
+    if (sourceSize.width() == 0 || sourceSize.height() == 0)
+    {
+        sourceRect = {0, 0, _size.width(), _size.height()};
+    }
+    SDL_Rect bounds = {_position.x(), _position.y(), (int)_texture->width(), (int)_texture->height()};
+    SDL_Rect visible;
+    if (!SDL_IntersectRect(&sourceRect, &bounds, &visible)) return;
+
+    _update();
+    Game::getInstance()->renderer()->drawTexture(
+        _texture.get(),
+        position + Point(visible.x - sourceRect.x, visible.y - sourceRect.y),
+        Point(visible.x, visible.y) - _position,
+        Size(visible.w, visible.h)
+    );
+}
+
+void PaletteOverlay::copyTo(Texture* destination, const Point& source)
+{
+    if (!_texture) return;
+
+    _update();
+    // Destination may start inside the overlay, SDL clips negative positions
+    SDL_Rect rect = {_position.x() - source.x(), _position.y() - source.y(), (int)_texture->width(), (int)_texture->height()};
+    SDL_BlitSurface(_texture->sdlSurface(), NULL, destination->sdlSurface(), &rect);
+    destination->update(rect);
+}
+
+}
+}
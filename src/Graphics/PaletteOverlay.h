@@ -0,0 +1,98 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FALLTERGEIST_GRAPHICS_PALETTEOVERLAY_H
+#define FALLTERGEIST_GRAPHICS_PALETTEOVERLAY_H
+
+// C++ standard includes
+#include <memory>
+#include <vector>
+
+// Falltergeist includes
+#include "../Point.h"
+
+// Third party includes
+#include <libfalltergeist/Enums.h>
+#include <SDL.h>
+
+namespace libfalltergeist
+{
+namespace Frm { class File; }
+}
+
+namespace Falltergeist
+{
+namespace Graphics
+{
+
+class AnimatedPalette;
+class Texture;
+
+/**
+ * @brief Animated palette pixels of one FRM, drawn over its regular texture.
+ * Only coordinates and palette indices of animated pixels are kept. The texture covers
+ * their bounding box and is updated when counters of AnimatedPalette change.
+ * Overlays are shared by all objects using the same FRM, see AnimatedPalette::overlay().
+ */
+class PaletteOverlay
+{
+public:
+    PaletteOverlay(libfalltergeist::Frm::File* frm, AnimatedPalette* palette);
+    ~PaletteOverlay();
+
+    bool empty() const;
+
+    /**
+     * Draws part of the overlay that covers given rectangle of FRM texture. Position is where the rectangle is drawn.
+     */
+    void render(const Point& position, const Point& source = Point(), const Size& sourceSize = Size());
+    /**
+     * Blits the overlay onto a copy of FRM texture. Source is the FRM texture point at top left corner of destination.
+     */
+    void copyTo(Texture* destination, const Point& source = Point());
+
+protected:
+    struct Pixel
+    {
+        unsigned int offset; // in overlay texture
+        unsigned char index;
+    };
+
+    struct Layer
+    {
+        MASK type;
+        std::vector<Pixel> pixels;
+        unsigned int counter;
+        // Bounding box of layer pixels in overlay texture, uploaded when counter changes
+        SDL_Rect bounds;
+    };
+
+    AnimatedPalette* _palette;
+    std::vector<Layer> _layers;
+    std::unique_ptr<Texture> _texture;
+    // Overlay texture position and FRM texture size
+    Point _position;
+    Size _size;
+
+    void _update();
+};
+
+}
+}
+#endif // FALLTERGEIST_GRAPHICS_PALETTEOVERLAY_H
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Related headers
+#include "../Graphics/PixelOps.h"
+
+// C++ standard includes
+
+// Falltergeist includes
+#include "../Logger.h"
+
+// Third party includes
+#include <SDL.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define FALLTERGEIST_PIXELOPS_SSE2
+    #include <emmintrin.h>
+    // AVX2 code is compiled with target attribute and used only when CPU reports it, SDL_HasAVX2() needs SDL 2.0.4
+    #if (defined(_MSC_VER) || defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)) && SDL_VERSION_ATLEAST(2, 0, 4)
+        #define FALLTERGEIST_PIXELOPS_AVX2
+        #include <immintrin.h>
+        #if defined(__GNUC__) || defined(__clang__)
+            #define FALLTERGEIST_TARGET_AVX2 __attribute__((target("avx2")))
+        #else
+            #define FALLTERGEIST_TARGET_AVX2
+        #endif
+    #endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define FALLTERGEIST_PIXELOPS_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace Falltergeist
+{
+namespace Graphics
+{
+
+namespace
+{
+
+void maskRowScalar(const uint32_t* source, const uint32_t* mask, uint32_t* destination, unsigned int width)
+{
+    for (unsigned int x = 0; x != width; ++x)
+    {
+        destination[x] = source[x] & mask[x];
+    }
+}
+
+#ifdef FALLTERGEIST_PIXELOPS_SSE2
+void maskRowSse2(const uint32_t* source, const uint32_t* mask, uint32_t* destination, unsigned int width)
+{
+    unsigned int x = 0;
+    for (; x + 4 <= width; x += 4)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(source + x));
+        __m128i maskPixels = _mm_loadu_si128((const __m128i*)(mask + x));
+        _mm_storeu_si128((__m128i*)(destination + x), _mm_and_si128(pixels, maskPixels));
+    }
+    maskRowScalar(source + x, mask + x, destination + x, width - x);
+}
+#endif
+
+#ifdef FALLTERGEIST_PIXELOPS_AVX2
+FALLTERGEIST_TARGET_AVX2
+void maskRowAvx2(const uint32_t* source, const uint32_t* mask, uint32_t* destination, unsigned int width)
+{
+    unsigned int x = 0;
+    for (; x + 8 <= width; x += 8)
+    {
+        __m256i pixels = _mm256_loadu_si256((const __m256i*)(source + x));
+        __m256i maskPixels = _mm256_loadu_si256((const __m256i*)(mask + x));
+        _mm256_storeu_si256((__m256i*)(destination + x), _mm256_and_si256(pixels, maskPixels));
+    }
+    maskRowSse2(source + x, mask + x, destination + x, width - x);
+}
+#endif
+
+#ifdef FALLTERGEIST_PIXELOPS_NEON
+void maskRowNeon(const uint32_t* source, const uint32_t* mask, uint32_t* destination, unsigned int width)
+{
+    unsigned int x = 0;
+    for (; x + 4 <= width; x += 4)
+    {
+        vst1q_u32(destination + x, vandq_u32(vld1q_u32(source + x), vld1q_u32(mask + x)));
+    }
+    maskRowScalar(source + x, mask + x, destination + x, width - x);
+}
+#endif
+
+}
+
+PixelOps::MaskRowFunction PixelOps::_maskRow = nullptr;
+std::string PixelOps::_instructionSet;
+
+void PixelOps::_init()
+{
+    _maskRow = &maskRowScalar;
+    _instructionSet = "scalar";
+#ifdef FALLTERGEIST_PIXELOPS_SSE2
+    if (SDL_HasSSE2())
+    {
+        _maskRow = &maskRowSse2;
+        _instructionSet = "SSE2";
+    }
+#endif
+#ifdef FALLTERGEIST_PIXELOPS_AVX2
+    if (SDL_HasAVX2())
+    {
+        _maskRow = &maskRowAvx2;
+        _instructionSet = "AVX2";
+    }
+#endif
+#ifdef FALLTERGEIST_PIXELOPS_NEON
+    // Compiled for NEON anyway, SDL_HasNEON() needs SDL 2.0.6
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+    if (SDL_HasNEON())
+#endif
+    {
+        _maskRow = &maskRowNeon;
+        _instructionSet = "NEON";
+    }
+#endif
+    Logger::info("RENDERER") << "Pixel kernels: " << _instructionSet << std::endl;
+}
+
+void PixelOps::maskRows(const uint32_t* source, unsigned int sourcePitch,
+                        const uint32_t* mask, unsigned int maskPitch,
+                        uint32_t* destination, unsigned int destinationPitch,
+                        unsigned int width, unsigned int height)
+{
+    if (!_maskRow) _init();
+
+    for (unsigned int y = 0; y != height; ++y)
+    {
+        _maskRow(source + y * sourcePitch, mask + y * maskPitch, destination + y * destinationPitch, width);
+    }
+}
+
+std::string PixelOps::instructionSet()
+{
+    if (!_maskRow) _init();
+    return _instructionSet;
+}
+
+}
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FALLTERGEIST_GRAPHICS_PIXELOPS_H
+#define FALLTERGEIST_GRAPHICS_PIXELOPS_H
+
+// C++ standard includes
+#include <cstdint>
+#include <string>
+
+// Falltergeist includes
+
+// Third party includes
+
+namespace Falltergeist
+{
+namespace Graphics
+{
+
+/**
+ * @brief Kernels working on raw 32-bit pixel rows. Pitches are given in pixels.
+ * The fastest implementation supported by CPU is picked on first use.
+ */
+class PixelOps
+{
+public:
+    /**
+     * destination = source & mask, for width x height pixels. Destination may be the same as source.
+     */
+    static void maskRows(const uint32_t* source, unsigned int sourcePitch,
+                         const uint32_t* mask, unsigned int maskPitch,
+                         uint32_t* destination, unsigned int destinationPitch,
+                         unsigned int width, unsigned int height);
+    /**
+     * Name of instruction set used by kernels.
+     */
+    static std::string instructionSet();
+
+protected:
+    typedef void (*MaskRowFunction)(const uint32_t* source, const uint32_t* mask, uint32_t* destination, unsigned int width);
+
+    static MaskRowFunction _maskRow;
+    static std::string _instructionSet;
+
+    static void _init();
+};
+
+}
+}
+#endif // FALLTERGEIST_GRAPHICS_PIXELOPS_H
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FALLTERGEIST_GRAPHICS_RENDERCACHE_H
+#define FALLTERGEIST_GRAPHICS_RENDERCACHE_H
+
+// C++ standard includes
+#include <vector>
+
+// Falltergeist includes
+#include "../Graphics/Renderer.h"
+#include "../Point.h"
+
+// Third party includes
+#include <SDL.h>
+
+namespace Falltergeist
+{
+namespace Graphics
+{
+
+/**
+ * @brief Screen sized texture that keeps composed output of a group of draw calls between frames.
+ * Renderer composes again only the part where draw calls differ from the previous frame, see Renderer::beginCache().
+ */
+class RenderCache
+{
+public:
+    RenderCache();
+    ~RenderCache();
+
+    /**
+     * Makes next frame compose everything again.
+     */
+    void invalidate();
+
+protected:
+    friend class Renderer;
+
+    SDL_Texture* _sdlTexture = nullptr;
+    Size _size;
+    bool _valid = false;
+    // Renderer::invalidateCaches() counter at the time of last composition
+    unsigned int _generation = 0;
+    // Draw calls of the last composition
+    std::vector<Renderer::DrawCommand> _commands;
+};
+
+}
+}
+#endif // FALLTERGEIST_GRAPHICS_RENDERCACHE_H
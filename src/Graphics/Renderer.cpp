@@ -21,13 +21,17 @@
 #include "../Graphics/Renderer.h"
 
 // C++ standard includes
+#include <algorithm>
 #include <cmath>
 
 // Falltergeist includes
 #include "../Base/StlFeatures.h"
 #include "../Event/State.h"
 #include "../Exception.h"
+#include "../Game/Clock.h"
 #include "../Game/Game.h"
+#include "../Graphics/RenderCache.h"
+#include "../Graphics/TextureAtlas.h"
 #include "../Input/Mouse.h"
 #include "../Logger.h"
 #include "../Settings.h"
@@ -42,6 +46,20 @@ namespace Graphics
 
 using namespace Base;
 
+namespace
+{
+// How many batches back a draw call may be moved to join a batch with the same texture
+const unsigned int BATCH_LOOKBACK = 16;
+// Sprite atlas: 4 pages of 2048x2048 take 64 MB of video memory at most
+const unsigned int ATLAS_PAGE_SIZE = 2048;
+const unsigned int ATLAS_MAX_PAGES = 4;
+
+bool intersects(const SDL_Rect& a, const SDL_Rect& b)
+{
+    return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+}
+
 Renderer::Renderer(unsigned int width, unsigned int height)
 {
     _size.setWidth(width);
@@ -89,7 +107,12 @@ void Renderer::init()
     Logger::info("RENDERER") << message + "[OK]" << std::endl;
 
     message =  "SDL_CreateRenderer - ";
-    _sdlRenderer = SDL_CreateRenderer(_sdlWindow, -1, SDL_RENDERER_ACCELERATED);
+    Uint32 rendererFlags = SDL_RENDERER_ACCELERATED;
+    if (Game::getInstance()->settings()->vsync())
+    {
+        rendererFlags |= SDL_RENDERER_PRESENTVSYNC;
+    }
+    _sdlRenderer = SDL_CreateRenderer(_sdlWindow, -1, rendererFlags);
     if (!_sdlRenderer)
     {
         throw Exception(message + "[FAIL]");
@@ -98,6 +121,11 @@ void Renderer::init()
     Logger::info("RENDERER") << message + "[OK]" << std::endl;
 
     SDL_SetRenderDrawBlendMode(_sdlRenderer, SDL_BLENDMODE_BLEND);
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+    _cacheBlendMode = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+                                                 SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+    _premultipliedAlpha = true;
+#endif
 
     if (Game::getInstance()->settings()->scale() != 0)
     {
@@ -129,6 +157,11 @@ void Renderer::init()
     {
         Logger::info("RENDERER") << "flags: SDL_RENDERER_ACCELERATED" << std::endl;
     }
+    if (rendererInfo.flags & SDL_RENDERER_PRESENTVSYNC)
+    {
+        Logger::info("RENDERER") << "flags: SDL_RENDERER_PRESENTVSYNC" << std::endl;
+        _vsync = true;
+    }
     Logger::info("RENDERER") << "num_texture_formats: " << rendererInfo.num_texture_formats << std::endl;
     for (unsigned int i = 0; i != 16; i++)
     {
@@ -170,15 +203,23 @@ void Renderer::init()
     }
     Logger::info("RENDERER") << "max_texture_width: " << rendererInfo.max_texture_width << std::endl;
     Logger::info("RENDERER") << "max_texture_height: " << rendererInfo.max_texture_height << std::endl;
+
+    unsigned int pageSize = ATLAS_PAGE_SIZE;
+    if (rendererInfo.max_texture_width > 0) pageSize = std::min(pageSize, (unsigned int)rendererInfo.max_texture_width);
+    if (rendererInfo.max_texture_height > 0) pageSize = std::min(pageSize, (unsigned int)rendererInfo.max_texture_height);
+    _atlas = make_unique<TextureAtlas>(_sdlRenderer, pageSize, ATLAS_MAX_PAGES);
 }
 
 void Renderer::think()
 {
     if (_fadeDone) return;
 
-    unsigned int ticks = SDL_GetTicks();
-    if (ticks - _fadeTimer > _fadeDelay)
+    // Fade takes the same time at any frame rate, short fades may take several alpha steps at once
+    _fadeTime += Game::getInstance()->clock()->delta();
+    unsigned int delay = std::max(_fadeDelay, 1u);
+    while (_fadeTime >= delay)
     {
+        _fadeTime -= delay;
         _fadeAlpha += _fadeStep;
         if (_fadeAlpha <= 0 || _fadeAlpha > 255)
         {
@@ -188,11 +229,16 @@ void Renderer::think()
             Game::getInstance()->topState()->emitEvent(make_unique<Event::State>("fadedone"));
             return;
         }
-        _fadeTimer = ticks;
     }
     _fadeColor.a = _fadeAlpha;
 }
 
+unsigned int Renderer::nextWakeUp() const
+{
+    if (_fadeDone) return Game::Clock::NEVER;
+    return Game::getInstance()->clock()->ticks() + std::max(_fadeDelay, 1u) - _fadeTime;
+}
+
 bool Renderer::fadeDone()
 {
     return _fadeDone && _fadeAlpha == 0;
@@ -211,6 +257,7 @@ void Renderer::fadeIn(uint8_t r, uint8_t g, uint8_t b, unsigned int time, bool i
     _fadeAlpha = 255;
     _fadeStep = -1;
     _fadeDone = false;
+    _fadeTime = 0;
     _fadeDelay = round(time / 256);
 }
 
@@ -221,6 +268,7 @@ void Renderer::fadeOut(uint8_t r, uint8_t g, uint8_t b, unsigned int time, bool
     _fadeAlpha = 0;
     _fadeStep = 1;
     _fadeDone = false;
+    _fadeTime = 0;
     _fadeDelay = round(time / 256);
 }
 
@@ -228,11 +276,11 @@ void Renderer::fadeOut(uint8_t r, uint8_t g, uint8_t b, unsigned int time, bool
 void Renderer::beginFrame()
 {
     SDL_RenderClear(_sdlRenderer);
-    think();
 }
 
 void Renderer::endFrame()
 {
+    flush();
     if (!fadeDone())
     {
         SDL_Color color;
@@ -244,6 +292,21 @@ void Renderer::endFrame()
     SDL_RenderPresent(_sdlRenderer);
 }
 
+bool Renderer::vsync() const
+{
+    return _vsync;
+}
+
+unsigned int Renderer::refreshRate()
+{
+    SDL_DisplayMode mode;
+    if (SDL_GetWindowDisplayMode(_sdlWindow, &mode) != 0 || mode.refresh_rate <= 0)
+    {
+        return 60;
+    }
+    return mode.refresh_rate;
+}
+
 int Renderer::width()
 {
     return _size.width();
@@ -262,17 +325,339 @@ const Size& Renderer::size() const
 void Renderer::drawTexture(Texture* texture, int x, int y, int sourceX, int sourceY, unsigned int sourceWidth, unsigned int sourceHeight)
 {
     if (!texture) return;
+
+    DrawCommand command;
     if (!sourceX && !sourceY && !sourceWidth && !sourceHeight)
     {
-        SDL_Rect dest = {(short)x, (short)y, (unsigned short)texture->width(), (unsigned short)texture->height()};
-        SDL_RenderCopy(_sdlRenderer, texture->sdlTexture(), NULL, &dest);
+        command.source = {0, 0, (int)texture->width(), (int)texture->height()};
+    }
+    else
+    {
+        command.source = {(short)sourceX, (short)sourceY, (unsigned short)sourceWidth, (unsigned short)sourceHeight};
+    }
+    command.destination = {(short)x, (short)y, command.source.w, command.source.h};
+
+    SDL_Rect screen = {0, 0, _size.width(), _size.height()};
+    if (!intersects(command.destination, screen)) return;
+
+    // Uploads pending changes, so it has to be done before the texture is marked as queued
+    command.sdlTexture = texture->sdlTexture();
+    if (texture->_atlasPage)
+    {
+        command.source.x += texture->_atlasX;
+        command.source.y += texture->_atlasY;
+        command.sdlTextureWidth = command.sdlTextureHeight = _atlas->pageSize();
+    }
+    else
+    {
+        command.sdlTextureWidth = texture->width();
+        command.sdlTextureHeight = texture->height();
+    }
+    command.texture = texture;
+    command.color = texture->colorModifier();
+    command.blendMode = texture->blendMode();
+    command.version = texture->version();
+    texture->_queued = true;
+    _commands.push_back(command);
+}
+
+void Renderer::flush()
+{
+    if (_commands.empty()) return;
+
+    if (_cache)
+    {
+        _flushIntoCache();
+        return;
+    }
+    _submitCommands();
+}
+
+void Renderer::_submitCommands()
+{
+    // Every draw call joins the latest batch with the same texture and blend mode,
+    // unless it overlaps something drawn after that batch
+    _batches.clear();
+    for (auto& command : _commands)
+    {
+        if (command.texture) command.texture->_queued = false;
+        command.batch = _batches.size();
+
+        unsigned int lookback = std::min<size_t>(BATCH_LOOKBACK, _batches.size());
+        for (unsigned int i = 0; i != lookback; ++i)
+        {
+            auto& batch = _batches.at(_batches.size() - 1 - i);
+            if (batch.sdlTexture == command.sdlTexture && batch.blendMode == command.blendMode)
+            {
+                command.batch = _batches.size() - 1 - i;
+                SDL_UnionRect(&batch.bounds, &command.destination, &batch.bounds);
+                break;
+            }
+            if (intersects(batch.bounds, command.destination)) break;
+        }
+        if (command.batch == _batches.size())
+        {
+            _batches.push_back({command.sdlTexture, command.blendMode, command.destination});
+        }
+    }
+
+    // Stable counting sort by batch keeps painter's order inside of every batch
+    _batchOffsets.assign(_batches.size() + 1, 0);
+    for (auto& command : _commands)
+    {
+        _batchOffsets.at(command.batch + 1)++;
+    }
+    for (unsigned int i = 1; i < _batchOffsets.size(); ++i)
+    {
+        _batchOffsets.at(i) += _batchOffsets.at(i - 1);
+    }
+    _sortedCommands.resize(_commands.size());
+    {
+        std::vector<unsigned int> positions(_batchOffsets.begin(), _batchOffsets.end() - 1);
+        for (auto& command : _commands)
+        {
+            _sortedCommands.at(positions.at(command.batch)++) = command;
+        }
+    }
+
+    for (unsigned int i = 0; i != _batches.size(); ++i)
+    {
+        _submit(&_sortedCommands.at(_batchOffsets.at(i)), _batchOffsets.at(i + 1) - _batchOffsets.at(i));
+    }
+    _commands.clear();
+}
+
+void Renderer::beginCache(RenderCache* cache)
+{
+    // Composed colors would be blended with alpha twice, so everything is drawn directly
+    if (!_premultipliedAlpha) return;
+
+    // Nested caches are composed into the outer one
+    if (_cacheDepth++ > 0) return;
+
+    // Everything drawn before goes to the screen
+    flush();
+    _cache = cache;
+}
+
+void Renderer::_flushIntoCache()
+{
+    // Texture is about to change or go away while its draw calls wait for endCache(), so they are composed right away.
+    // Composed part can't be compared with the previous frame, the whole cache is composed again
+    _prepareCache(_cache);
+    SDL_SetRenderTarget(_sdlRenderer, _cache->_sdlTexture);
+    if (!_cacheComposing)
+    {
+        _cacheComposing = true;
+        _cacheComposed.clear();
+        _clearCache({0, 0, _size.width(), _size.height()});
+    }
+    _cacheComposed.insert(_cacheComposed.end(), _commands.begin(), _commands.end());
+    _submitCommands();
+    SDL_SetRenderTarget(_sdlRenderer, nullptr);
+}
+
+void Renderer::_prepareCache(RenderCache* cache)
+{
+    if (cache->_sdlTexture && cache->_size == _size) return;
+
+    if (cache->_sdlTexture) SDL_DestroyTexture(cache->_sdlTexture);
+    cache->_sdlTexture = SDL_CreateTexture(_sdlRenderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, _size.width(), _size.height());
+    if (!cache->_sdlTexture)
+    {
+        throw Exception(SDL_GetError());
+    }
+    SDL_SetTextureBlendMode(cache->_sdlTexture, _cacheBlendMode);
+    cache->_size = _size;
+    cache->_valid = false;
+}
+
+void Renderer::_clearCache(const SDL_Rect& rect)
+{
+    // Blending into transparent pixels leaves colors multiplied by alpha
+    SDL_Color color;
+    SDL_GetRenderDrawColor(_sdlRenderer, &color.r, &color.g, &color.b, &color.a);
+    SDL_SetRenderDrawBlendMode(_sdlRenderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(_sdlRenderer, 0, 0, 0, 0);
+    SDL_RenderFillRect(_sdlRenderer, &rect);
+    SDL_SetRenderDrawBlendMode(_sdlRenderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(_sdlRenderer, color.r, color.g, color.b, color.a);
+}
+
+void Renderer::endCache()
+{
+    if (_cacheDepth == 0 || --_cacheDepth > 0) return;
+
+    auto cache = _cache;
+    _cache = nullptr;
+
+    for (auto& command : _commands)
+    {
+        command.texture->_queued = false;
+    }
+
+    _prepareCache(cache);
+
+    if (_cacheComposing)
+    {
+        // The rest goes over what flush() composed already
+        _cacheComposing = false;
+        _cacheComposed.insert(_cacheComposed.end(), _commands.begin(), _commands.end());
+        cache->_commands.swap(_cacheComposed);
+        cache->_valid = true;
+        cache->_generation = _cacheGeneration;
+
+        SDL_SetRenderTarget(_sdlRenderer, cache->_sdlTexture);
+        flush();
+        SDL_SetRenderTarget(_sdlRenderer, nullptr);
+        _drawCache(cache);
+        return;
+    }
+
+    // Union of draw calls that differ from the previous frame, where they were and where they are now
+    SDL_Rect screen = {0, 0, _size.width(), _size.height()};
+    SDL_Rect dirty = {0, 0, 0, 0};
+    auto invalidate = [&dirty](const SDL_Rect& rect)
+    {
+        if (SDL_RectEmpty(&dirty))
+        {
+            dirty = rect;
+        }
+        else
+        {
+            SDL_UnionRect(&dirty, &rect, &dirty);
+        }
+    };
+    if (!cache->_valid || cache->_generation != _cacheGeneration)
+    {
+        dirty = screen;
     }
     else
     {
-        SDL_Rect dest = {(short)x, (short)y, (unsigned short)sourceWidth, (unsigned short)sourceHeight};
-        SDL_Rect src = {(short)sourceX, (short)sourceY, (unsigned short)sourceWidth, (unsigned short)sourceHeight};
-        SDL_RenderCopy(_sdlRenderer, texture->sdlTexture(), &src, &dest);
+        auto& previous = cache->_commands;
+        for (unsigned int i = 0; i < std::max(previous.size(), _commands.size()); ++i)
+        {
+            if (i >= previous.size())
+            {
+                invalidate(_commands.at(i).destination);
+                continue;
+            }
+            if (i >= _commands.size())
+            {
+                invalidate(previous.at(i).destination);
+                continue;
+            }
+            auto& a = previous.at(i);
+            auto& b = _commands.at(i);
+            if (a.sdlTexture != b.sdlTexture || a.version != b.version || a.blendMode != b.blendMode
+                || !SDL_RectEquals(&a.source, &b.source) || !SDL_RectEquals(&a.destination, &b.destination)
+                || a.color.r != b.color.r || a.color.g != b.color.g || a.color.b != b.color.b || a.color.a != b.color.a)
+            {
+                invalidate(a.destination);
+                invalidate(b.destination);
+            }
+        }
+    }
+    cache->_commands = _commands;
+    cache->_valid = true;
+    cache->_generation = _cacheGeneration;
+
+    if (SDL_IntersectRect(&dirty, &screen, &dirty))
+    {
+        // Draw calls outside of the changed part are composed already
+        _commands.erase(std::remove_if(_commands.begin(), _commands.end(), [&dirty](const DrawCommand& command)
+        {
+            return !intersects(command.destination, dirty);
+        }), _commands.end());
+
+        SDL_SetRenderTarget(_sdlRenderer, cache->_sdlTexture);
+        SDL_RenderSetClipRect(_sdlRenderer, &dirty);
+        _clearCache(dirty);
+        flush();
+
+        SDL_RenderSetClipRect(_sdlRenderer, nullptr);
+        SDL_SetRenderTarget(_sdlRenderer, nullptr);
     }
+    _commands.clear();
+    _drawCache(cache);
+}
+
+bool Renderer::drawCache(RenderCache* cache)
+{
+    if (!_premultipliedAlpha) return false;
+    if (!cache->_valid || cache->_generation != _cacheGeneration || cache->_size != _size) return false;
+
+    _drawCache(cache);
+    return true;
+}
+
+void Renderer::_drawCache(RenderCache* cache)
+{
+    SDL_Rect screen = {0, 0, _size.width(), _size.height()};
+    DrawCommand command;
+    command.texture = nullptr;
+    command.sdlTexture = cache->_sdlTexture;
+    command.source = screen;
+    command.destination = screen;
+    command.color = {255, 255, 255, 255};
+    command.blendMode = _cacheBlendMode;
+    command.sdlTextureWidth = _size.width();
+    command.sdlTextureHeight = _size.height();
+    command.version = 0;
+    _commands.push_back(command);
+}
+
+void Renderer::invalidateCaches()
+{
+    _cacheGeneration++;
+}
+
+void Renderer::_submit(const DrawCommand* commands, unsigned int count)
+{
+    auto sdlTexture = commands[0].sdlTexture;
+    SDL_SetTextureBlendMode(sdlTexture, commands[0].blendMode);
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    // Color modifiers go to vertices, so draw calls with different modifiers share the batch
+    SDL_SetTextureColorMod(sdlTexture, 255, 255, 255);
+    SDL_SetTextureAlphaMod(sdlTexture, 255);
+
+    _vertices.clear();
+    _indices.clear();
+    for (unsigned int i = 0; i != count; ++i)
+    {
+        auto& command = commands[i];
+        float width = command.sdlTextureWidth;
+        float height = command.sdlTextureHeight;
+        float left = command.source.x / width;
+        float top = command.source.y / height;
+        float right = (command.source.x + command.source.w) / width;
+        float bottom = (command.source.y + command.source.h) / height;
+        float x = command.destination.x;
+        float y = command.destination.y;
+        float w = command.destination.w;
+        float h = command.destination.h;
+
+        int index = _vertices.size();
+        _vertices.push_back({{x,     y    }, command.color, {left,  top   }});
+        _vertices.push_back({{x + w, y    }, command.color, {right, top   }});
+        _vertices.push_back({{x + w, y + h}, command.color, {right, bottom}});
+        _vertices.push_back({{x,     y + h}, command.color, {left,  bottom}});
+        for (int offset : {0, 1, 2, 0, 2, 3})
+        {
+            _indices.push_back(index + offset);
+        }
+    }
+    SDL_RenderGeometry(_sdlRenderer, sdlTexture, _vertices.data(), _vertices.size(), _indices.data(), _indices.size());
+#else
+    for (unsigned int i = 0; i != count; ++i)
+    {
+        auto& command = commands[i];
+        SDL_SetTextureColorMod(sdlTexture, command.color.r, command.color.g, command.color.b);
+        SDL_SetTextureAlphaMod(sdlTexture, command.color.a);
+        SDL_RenderCopy(_sdlRenderer, sdlTexture, &command.source, &command.destination);
+    }
+#endif
 }
 
 void Renderer::drawTexture(Texture* texture, const Point& pos, const Point& src, const Size& srcSize)
@@ -282,6 +667,7 @@ void Renderer::drawTexture(Texture* texture, const Point& pos, const Point& src,
 
 std::unique_ptr<Texture> Renderer::screenshot()
 {
+    flush();
     SDL_Surface* window = SDL_GetWindowSurface(sdlWindow());
     if (!window)
     {
@@ -295,6 +681,11 @@ std::unique_ptr<Texture> Renderer::screenshot()
     return texture;
 }
 
+TextureAtlas* Renderer::atlas()
+{
+    return _atlas.get();
+}
+
 std::string Renderer::name()
 {
     return _name;
@@ -315,6 +706,16 @@ SDL_Renderer* Renderer::sdlRenderer()
     return _sdlRenderer;
 }
 
+bool Renderer::premultipliedAlpha()
+{
+    return _premultipliedAlpha;
+}
+
+SDL_BlendMode Renderer::premultipliedBlendMode()
+{
+    return _cacheBlendMode;
+}
+
 float Renderer::scaleX()
 {
     return _scaleX;
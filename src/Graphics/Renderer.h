@@ -37,6 +37,9 @@ namespace Falltergeist
 namespace Graphics
 {
 
+class RenderCache;
+class TextureAtlas;
+
 class Renderer
 {
 
@@ -49,7 +52,23 @@ public:
 
     void beginFrame();
     void endFrame();
+    /**
+     * Advances fading by one simulation step.
+     */
     void think();
+    /**
+     * Simulation time of the next fade step, Game::Clock::NEVER when not fading.
+     */
+    unsigned int nextWakeUp() const;
+
+    /**
+     * Whether presenting a frame waits for display refresh.
+     */
+    bool vsync() const;
+    /**
+     * Display refresh rate, 60 when it is unknown.
+     */
+    unsigned int refreshRate();
 
     int width();
     int height();
@@ -70,16 +89,76 @@ public:
 
     std::string name();
 
+    /**
+     * Draw calls are recorded and submitted in batches by flush().
+     */
     void drawTexture(Texture* texture, int x, int y, int sourceX = 0, int sourceY = 0, int unsigned sourceWidth = 0, unsigned int sourceHeight = 0);
     void drawTexture(Texture* texture, const Point& pos, const Point& src = Point(), const Size& srcSize = Size());
+    /**
+     * Submits recorded draw calls. Must be called before using SDL renderer directly.
+     * Between beginCache() and endCache() draw calls are composed into the cache instead.
+     */
+    void flush();
+
+    /**
+     * Draw calls until endCache() are composed into the cache, which is then drawn with a single draw call.
+     * Only the part of the cache where draw calls differ from the previous frame is composed again.
+     * Without premultipliedAlpha() draw calls go to the screen directly.
+     */
+    void beginCache(RenderCache* cache);
+    void endCache();
+    /**
+     * Draws what was composed into the cache last time without composing it again.
+     * Returns false when the cache has nothing valid to draw.
+     */
+    bool drawCache(RenderCache* cache);
+    /**
+     * Makes all caches compose everything again, e.g. after render targets are lost.
+     */
+    void invalidateCaches();
+    /**
+     * Blend mode for textures whose colors are multiplied by alpha already.
+     * premultipliedAlpha() is false when SDL is too old to compose it.
+     */
+    bool premultipliedAlpha();
+    SDL_BlendMode premultipliedBlendMode();
 
     std::unique_ptr<Texture> screenshot();
+    /**
+     * Shared pages for sprites, see ResourceManager::texture().
+     */
+    TextureAtlas* atlas();
 
 protected:
+    friend class RenderCache;
+
+    struct DrawCommand
+    {
+        Texture* texture; // nullptr for caches
+        SDL_Texture* sdlTexture;
+        SDL_Rect source;
+        SDL_Rect destination;
+        SDL_Color color;
+        SDL_BlendMode blendMode;
+        // Size of sdlTexture, it is an atlas page for textures in atlas
+        unsigned int sdlTextureWidth;
+        unsigned int sdlTextureHeight;
+        unsigned int batch;
+        uint64_t version;
+    };
+
+    struct Batch
+    {
+        SDL_Texture* sdlTexture;
+        SDL_BlendMode blendMode;
+        // Union of destination rectangles, later draw calls overlapping it can't be moved before the batch
+        SDL_Rect bounds;
+    };
+
     Size _size;
 
     short _fadeStep = 0;
-    unsigned int _fadeTimer = 0;
+    unsigned int _fadeTime = 0;
     unsigned int _fadeDelay = 0;
     unsigned int _fadeAlpha = 0;
     bool _fadeDone = true;
@@ -87,12 +166,42 @@ protected:
 
     bool _inmovie = false;
 
+    bool _vsync = false;
+
     float _scaleX = 1.0;
     float _scaleY = 1.0;
 
     std::string _name;
     SDL_Window* _sdlWindow;
     SDL_Renderer* _sdlRenderer;
+    std::unique_ptr<TextureAtlas> _atlas;
+
+    // Kept between frames to avoid reallocations
+    std::vector<DrawCommand> _commands;
+    std::vector<DrawCommand> _sortedCommands;
+    std::vector<Batch> _batches;
+    std::vector<unsigned int> _batchOffsets;
+
+    RenderCache* _cache = nullptr;
+    unsigned int _cacheDepth = 0;
+    unsigned int _cacheGeneration = 0;
+    // Cache is composed from scratch while it is recorded, because texture changed under queued draw calls
+    bool _cacheComposing = false;
+    std::vector<DrawCommand> _cacheComposed;
+    // Premultiplied alpha, composed caches have colors multiplied by alpha already
+    SDL_BlendMode _cacheBlendMode = SDL_BLENDMODE_BLEND;
+    bool _premultipliedAlpha = false;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    std::vector<SDL_Vertex> _vertices;
+    std::vector<int> _indices;
+#endif
+
+    void _submitCommands();
+    void _submit(const DrawCommand* commands, unsigned int count);
+    void _flushIntoCache();
+    void _prepareCache(RenderCache* cache);
+    void _clearCache(const SDL_Rect& rect);
+    void _drawCache(RenderCache* cache);
 };
 
 }
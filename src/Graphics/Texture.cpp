@@ -21,11 +21,15 @@
 #include "../Graphics/Texture.h"
 
 // C++ standard includes
+#include <algorithm>
+#include <cstring>
 
 // Falltergeist includes
 #include "../Base/StlFeatures.h"
 #include "../Game/Game.h"
+#include "../Graphics/PixelOps.h"
 #include "../Graphics/Renderer.h"
+#include "../Graphics/TextureAtlas.h"
 #include "../Exception.h"
 
 // Third party includes
@@ -37,6 +41,15 @@ namespace Graphics
 
 using namespace Base;
 
+namespace
+{
+// Surface of immutable texture is freed only when its pixels were not read for that long (ms),
+// so sprites masked every frame are not restored from their source every frame
+const unsigned int SURFACE_KEEP_TIME = 1000;
+}
+
+uint64_t Texture::_lastVersion = 0;
+
 Texture::Texture(unsigned int width, unsigned int height)
 {
     _width = width;
@@ -44,6 +57,15 @@ Texture::Texture(unsigned int width, unsigned int height)
     _init();
 }
 
+Texture::Texture(unsigned int width, unsigned int height, TextureAtlas* atlas)
+{
+    _width = width;
+    _height = height;
+    _atlas = atlas;
+    if (_atlas) _atlas->attach(this);
+    _init();
+}
+
 Texture::Texture(SDL_Surface* surface)
 {
     _width = surface->w;
@@ -54,11 +76,25 @@ Texture::Texture(SDL_Surface* surface)
 
 Texture::~Texture()
 {
-    SDL_FreeSurface(_sdlSurface);
-    SDL_DestroyTexture(_sdlTexture);
+    if (_queued) Game::getInstance()->renderer()->flush();
+    if (_atlas) _atlas->detach(this);
+    if (_sdlSurface) SDL_FreeSurface(_sdlSurface);
+    if (_sdlTexture) SDL_DestroyTexture(_sdlTexture);
 }
 
 void Texture::_init()
+{
+    _version = ++_lastVersion;
+    _createSurface();
+
+    // Atlas textures get their place on first draw
+    if (!_atlas)
+    {
+        _createSdlTexture();
+    }
+}
+
+void Texture::_createSurface()
 {
     Uint32 rmask, gmask, bmask, amask;
 
@@ -82,8 +118,12 @@ void Texture::_init()
     }
 
     SDL_SetSurfaceBlendMode(_sdlSurface, SDL_BLENDMODE_BLEND);
+}
 
-    _sdlTexture = SDL_CreateTexture(Game::getInstance()->renderer()->sdlRenderer(), SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, width(), height());
+void Texture::_createSdlTexture()
+{
+    int access = _streaming ? SDL_TEXTUREACCESS_STREAMING : SDL_TEXTUREACCESS_STATIC;
+    _sdlTexture = SDL_CreateTexture(Game::getInstance()->renderer()->sdlRenderer(), SDL_PIXELFORMAT_RGBA8888, access, width(), height());
     if(!_sdlTexture)
     {
         throw Exception(SDL_GetError());
@@ -93,6 +133,11 @@ void Texture::_init()
     setColorModifier(_colorModifier);
 }
 
+uint64_t Texture::version()
+{
+    return _version;
+}
+
 unsigned int Texture::width()
 {
     return _width;
@@ -105,13 +150,113 @@ unsigned int Texture::height()
 
 void Texture::update()
 {
-   _changed = true;
+    SDL_Rect rect = {0, 0, (int)width(), (int)height()};
+    update(rect);
+}
+
+void Texture::update(const SDL_Rect& rect)
+{
+    // Changed pixels can not be restored from source any more
+    if (!_sdlSurface) _restoreSurface();
+    _pixelSource = nullptr;
+    _alphaMask.clear();
+    _markChanged(rect);
+}
+
+void Texture::_markChanged(const SDL_Rect& rect)
+{
+    SDL_Rect bounds = {0, 0, (int)width(), (int)height()};
+    SDL_Rect clipped;
+    if (!SDL_IntersectRect(&rect, &bounds, &clipped)) return;
+
+    if (_changed)
+    {
+        SDL_UnionRect(&_dirty, &clipped, &_dirty);
+    }
+    else
+    {
+        _dirty = clipped;
+    }
+    _changed = true;
+    _version = ++_lastVersion;
+}
+
+void Texture::setStreaming(bool value)
+{
+    if (_streaming == value) return;
+
+    if (_queued) Game::getInstance()->renderer()->flush();
+    _streaming = value;
+    if (_atlas) _atlas->detach(this);
+    _atlas = nullptr;
+    _atlasPage = nullptr;
+    if (_sdlTexture) SDL_DestroyTexture(_sdlTexture);
+    _sdlTexture = nullptr;
+    _createSdlTexture();
+    SDL_Rect rect = {0, 0, (int)width(), (int)height()};
+    _markChanged(rect);
+}
+
+bool Texture::streaming()
+{
+    return _streaming;
+}
+
+void Texture::setPixelSource(std::function<void(Texture*)> source)
+{
+    _pixelSource = source;
+    _buildAlphaMask();
+}
+
+void Texture::_buildAlphaMask()
+{
+    _alphaMask.assign((width() * height() + 7) / 8, 0);
+    _lock();
+    auto pixels = (const uint32_t*)_sdlSurface->pixels;
+    for (unsigned int i = 0; i != width() * height(); ++i)
+    {
+        if (pixels[i] & 0xFF) _alphaMask[i / 8] |= 1 << (i % 8);
+    }
+    _unlock();
+}
+
+void Texture::_releaseSurface()
+{
+    if (_alphaMask.empty()) _buildAlphaMask();
+    SDL_FreeSurface(_sdlSurface);
+    _sdlSurface = nullptr;
+}
+
+void Texture::_restoreSurface()
+{
+    // Restoring pixels is not a change, texture stays immutable and nothing is uploaded
+    auto source = _pixelSource;
+    bool changed = _changed;
+    SDL_Rect dirty = _dirty;
+    auto version = _version;
+    auto alphaMask = std::move(_alphaMask);
+
+    _createSurface();
+    source(this);
+
+    _pixelSource = source;
+    _changed = changed;
+    _dirty = dirty;
+    _version = version;
+    _alphaMask = std::move(alphaMask);
 }
 
 unsigned int Texture::pixel(unsigned int x, unsigned int y)
 {
     if (x >= _width || y >= _height) return 0;
 
+    // Immutable textures are hit-tested without touching the surface
+    if (!_alphaMask.empty())
+    {
+        unsigned int i = y * width() + x;
+        return (_alphaMask[i / 8] & (1 << (i % 8))) ? 0xFFFFFFFF : 0;
+    }
+
     unsigned int pixel = 0;
 
     if (SDL_MUSTLOCK(_sdlSurface))
@@ -134,6 +279,8 @@ void Texture::setPixel(unsigned int x, unsigned int y, unsigned int color)
 {
     if (x >= _width || y >= _height) return;
 
+    sdlSurface();
+
     if (SDL_MUSTLOCK(_sdlSurface))
     {
         SDL_LockSurface(_sdlSurface);
@@ -147,11 +294,15 @@ void Texture::setPixel(unsigned int x, unsigned int y, unsigned int color)
         SDL_UnlockSurface(_sdlSurface);
     }
 
-    update();
+    SDL_Rect rect = {(int)x, (int)y, 1, 1};
+    update(rect);
 }
 
 void Texture::loadFromRGB(unsigned int* data)
 {
+    // Every pixel is overwritten, there is nothing to restore
+    if (!_sdlSurface) _createSurface();
+
     if (SDL_MUSTLOCK(_sdlSurface))
     {
         SDL_LockSurface(_sdlSurface);
@@ -174,6 +325,9 @@ void Texture::loadFromRGB(unsigned int* data)
 
 void Texture::loadFromRGBA(unsigned int* data)
 {
+    // Every pixel is overwritten, there is nothing to restore
+    if (!_sdlSurface) _createSurface();
+
     if (SDL_MUSTLOCK(_sdlSurface))
     {
         SDL_LockSurface(_sdlSurface);
@@ -209,8 +363,9 @@ void Texture::copyTo(Texture* destination, unsigned int destinationX, unsigned i
     SDL_Rect src = {(int)sourceX, (int)sourceY, (int)sourceWidth,(int)sourceHeight};
     SDL_Rect dst = {(int)destinationX, (int)destinationY, (int)sourceWidth,(int)sourceHeight};
 
+    // Destination rectangle is clipped by SDL to the area actually changed
     SDL_BlitSurface(sdlSurface(), &src, destination->sdlSurface(), &dst);
-    destination->update();
+    destination->update(dst);
 }
 
 void Texture::fill(unsigned int color)
@@ -250,18 +405,78 @@ Texture* Texture::fitTo(unsigned int width, unsigned int height)
 
 SDL_Surface* Texture::sdlSurface()
 {
+    if (!_sdlSurface) _restoreSurface();
+    _surfaceUsed = SDL_GetTicks();
     return _sdlSurface;
 }
 
 SDL_Texture* Texture::sdlTexture()
 {
+    // Texture that did not fit lives on its own until atlas reclaims space
+    if (_atlas && !_atlasPage && (!_sdlTexture || (!_queued && _atlasGeneration != _atlas->generation())))
+    {
+        _atlasGeneration = _atlas->generation();
+        if (_atlas->allocate(this))
+        {
+            if (_sdlTexture) SDL_DestroyTexture(_sdlTexture);
+            _sdlTexture = nullptr;
+            SDL_Rect rect = {0, 0, (int)width(), (int)height()};
+            _markChanged(rect);
+        }
+        else if (!_sdlTexture)
+        {
+            _createSdlTexture();
+            SDL_Rect rect = {0, 0, (int)width(), (int)height()};
+            _markChanged(rect);
+        }
+    }
+    if (_atlasPage) _atlasUsed = SDL_GetTicks();
+
     if (_changed)
     {
-        SDL_UpdateTexture(_sdlTexture, NULL, _sdlSurface->pixels, _sdlSurface->pitch);
+        // Draw calls recorded earlier this frame have to show old pixels
+        if (_queued) Game::getInstance()->renderer()->flush();
+        sdlSurface();
+        _upload();
         _changed = false;
+    }
 
+    // Renderer has its own copy now
+    if (_pixelSource && _sdlSurface && !_streaming && SDL_GetTicks() - _surfaceUsed >= SURFACE_KEEP_TIME)
+    {
+        _releaseSurface();
+    }
+    return _atlasPage ? _atlasPage : _sdlTexture;
+}
+
+void Texture::_upload()
+{
+    auto pixels = (const unsigned char*)_sdlSurface->pixels + _dirty.y * _sdlSurface->pitch + _dirty.x * 4;
+
+    if (_atlasPage)
+    {
+        SDL_Rect region = {(int)_atlasX + _dirty.x, (int)_atlasY + _dirty.y, _dirty.w, _dirty.h};
+        SDL_UpdateTexture(_atlasPage, &region, pixels, _sdlSurface->pitch);
+    }
+    else if (_streaming)
+    {
+        void* data;
+        int pitch;
+        if (SDL_LockTexture(_sdlTexture, &_dirty, &data, &pitch) != 0)
+        {
+            throw Exception(SDL_GetError());
+        }
+        // Locked pixels are write-only, the whole rectangle has to be written
+        for (int y = 0; y != _dirty.h; ++y)
+        {
+            std::memcpy((unsigned char*)data + y * pitch, pixels + y * _sdlSurface->pitch, _dirty.w * 4);
+        }
+        SDL_UnlockTexture(_sdlTexture);
+    }
+    else
+    {
+        SDL_UpdateTexture(_sdlTexture, &_dirty, pixels, _sdlSurface->pitch);
     }
-    return _sdlTexture;
 }
 
 SDL_Color Texture::colorModifier()
@@ -272,6 +487,8 @@ SDL_Color Texture::colorModifier()
 void Texture::setColorModifier(SDL_Color color)
 {
     _colorModifier = color;
+    // Atlas pages are shared, Renderer applies modifier of every draw call
+    if (!_sdlTexture) return;
     SDL_SetTextureColorMod(_sdlTexture, color.r, color.g, color.b);
     SDL_SetTextureAlphaMod(_sdlTexture, color.a);
 }
@@ -279,6 +496,7 @@ void Texture::setColorModifier(SDL_Color color)
 void Texture::setBlendMode(SDL_BlendMode blendMode)
 {
     _blendMode = blendMode;
+    if (!_sdlTexture) return;
     SDL_SetTextureBlendMode(_sdlTexture, _blendMode);
 }
 
@@ -287,31 +505,43 @@ SDL_BlendMode Texture::blendMode()
     return _blendMode;
 }
 
-bool Texture::blitWithAlpha(Texture* blitMask, int maskOffsetX, int maskOffsetY)
+void Texture::copyMasked(Texture* source, const SDL_Rect& sourceRect, Texture* mask, unsigned int maskX, unsigned int maskY)
 {
-    if (!blitMask)
-        return false;
-
-    // TODO: Lock both surfaces only once and then use direct pixel access to blend.
-    const auto thisWidth = width();
-    const auto thisHeight = height();
-    const auto maskWidth = blitMask->width();
-    const auto maskHeight = blitMask->height();
+    if (sourceRect.x < 0 || sourceRect.y < 0 || sourceRect.w <= 0 || sourceRect.h <= 0) return;
+
+    unsigned int rectWidth = std::min({(unsigned)sourceRect.w, width(), source->width() - std::min(source->width(), (unsigned)sourceRect.x), mask->width() - std::min(mask->width(), maskX)});
+    unsigned int rectHeight = std::min({(unsigned)sourceRect.h, height(), source->height() - std::min(source->height(), (unsigned)sourceRect.y), mask->height() - std::min(mask->height(), maskY)});
+    if (rectWidth == 0 || rectHeight == 0) return;
+
+    _lock();
+    if (source != this) source->_lock();
+    mask->_lock();
+    auto sourcePixels = (const uint32_t*)source->_sdlSurface->pixels + sourceRect.y * source->width() + sourceRect.x;
+    auto maskPixels = (const uint32_t*)mask->_sdlSurface->pixels + maskY * mask->width() + maskX;
+    PixelOps::maskRows(sourcePixels, source->width(), maskPixels, mask->width(), (uint32_t*)_sdlSurface->pixels, width(), rectWidth, rectHeight);
+    mask->_unlock();
+    if (source != this) source->_unlock();
+    _unlock();
+
+    SDL_Rect rect = {0, 0, (int)rectWidth, (int)rectHeight};
+    update(rect);
+}
 
-    //This is sloooow. But unfortunately sdl doesnt allow to blit over only alpha =/
-    for (unsigned int maskX = std::max(0, maskOffsetX), x = maskX - maskOffsetX;
-         x < thisWidth && maskX < maskWidth;
-         ++x, ++maskX)
+void Texture::_lock()
+{
+    sdlSurface();
+    if (SDL_MUSTLOCK(_sdlSurface))
     {
-        for (unsigned int maskY = std::max(0, maskOffsetY), y = maskY - maskOffsetY;
-             y < thisHeight && maskY < maskHeight;
-             ++y, ++maskY)
-        {
-            setPixel(x, y, pixel(x,y) & blitMask->pixel(maskX, maskY));
-        }
+        SDL_LockSurface(_sdlSurface);
     }
+}
 
-    return true;
+void Texture::_unlock()
+{
+    if (SDL_MUSTLOCK(_sdlSurface))
+    {
+        SDL_UnlockSurface(_sdlSurface);
+    }
 }
 
 // static
@@ -21,7 +21,10 @@
 #define FALLTERGEIST_GRAPHICS_TEXTURE_H
 
 // C++ standard includes
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <vector>
 
 // Falltergeist includes
 
@@ -33,22 +36,55 @@ namespace Falltergeist
 namespace Graphics
 {
 
+class TextureAtlas;
+
 class Texture
 {
 
 public:
     Texture(unsigned int width, unsigned int height);
+    /**
+     * Texture placed into atlas page instead of own SDL texture.
+     */
+    Texture(unsigned int width, unsigned int height, TextureAtlas* atlas);
     Texture(SDL_Surface* surface);
     ~Texture();
 
     SDL_Surface* sdlSurface();
     SDL_Texture* sdlTexture();
 
+    /**
+     * Marks whole texture to be uploaded when it is drawn next time.
+     */
     void update();
+    /**
+     * Marks rectangle of texture to be uploaded. Changed rectangles are merged into their union.
+     */
+    void update(const SDL_Rect& rect);
+
+    /**
+     * Streaming textures are uploaded with SDL_LockTexture and never placed into atlas.
+     * Meant for textures changed every frame.
+     */
+    void setStreaming(bool value);
+    bool streaming();
+
+    /**
+     * Makes texture immutable. 1-bit alpha mask is built for pixel(), which returns 0xFFFFFFFF for any visible pixel then.
+     * Surface is freed after upload once its pixels were not used for a while.
+     * Source is called to fill the surface again when pixels are needed, e.g. for copyTo() or atlas eviction.
+     * Changing pixels afterwards makes texture regular again.
+     */
+    void setPixelSource(std::function<void(Texture*)> source);
 
     SDL_Color colorModifier();
     void setColorModifier(SDL_Color color);
 
+    /**
+     * Changes whenever pixels change. Versions are never reused, not even by other textures.
+     */
+    uint64_t version();
+
     unsigned int width();
     unsigned int height();
 
@@ -69,7 +105,11 @@ public:
     void setBlendMode(SDL_BlendMode blendMode);
     SDL_BlendMode blendMode();
 
-    bool blitWithAlpha(Texture* blitMask, int maskOffsetX, int maskOffsetY);
+    /**
+     * Copies rectangle of source texture to the top left corner of this one, ANDing every pixel with mask.
+     * Mask pixel at (maskX, maskY) corresponds to the top left pixel of the rectangle. Source may be this texture.
+     */
+    void copyMasked(Texture* source, const SDL_Rect& sourceRect, Texture* mask, unsigned int maskX, unsigned int maskY);
 
     // Helpers to build some specific textures.
     static std::unique_ptr<Texture> generateTextureForNumber(
@@ -82,6 +122,8 @@ public:
         bool isSigned = false);
 
 protected:
+    friend class Renderer;
+    friend class TextureAtlas;
 
     unsigned int _width = 0;
     unsigned int _height = 0;
@@ -93,8 +135,40 @@ protected:
     SDL_BlendMode _blendMode = SDL_BLENDMODE_BLEND;
 
     bool _changed = false;
+    uint64_t _version = 0;
+    static uint64_t _lastVersion;
+    // Union of rectangles changed since last upload
+    SDL_Rect _dirty = {0, 0, 0, 0};
+    bool _streaming = false;
+
+    std::function<void(Texture*)> _pixelSource;
+    // SDL ticks of last access to surface pixels
+    unsigned int _surfaceUsed = 0;
+    // Bit per pixel, set where alpha is not zero. Immutable textures only
+    std::vector<uint8_t> _alphaMask;
+    // Renderer has draw calls with this texture that are not submitted yet
+    bool _queued = false;
+
+    TextureAtlas* _atlas = nullptr;
+    // Atlas page holding the pixels, nullptr until the texture is drawn for the first time or after eviction
+    SDL_Texture* _atlasPage = nullptr;
+    unsigned int _atlasX = 0;
+    unsigned int _atlasY = 0;
+    // SDL ticks of last draw from atlas page
+    unsigned int _atlasUsed = 0;
+    // TextureAtlas::generation() when atlas had no place for the texture
+    unsigned int _atlasGeneration = 0;
 
     void _init();
+    void _createSurface();
+    void _createSdlTexture();
+    void _markChanged(const SDL_Rect& rect);
+    void _buildAlphaMask();
+    void _releaseSurface();
+    void _restoreSurface();
+    void _lock();
+    void _unlock();
+    void _upload();
 };
 
 }
@@ -0,0 +1,283 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Related headers
+#include "../Graphics/TextureAtlas.h"
+
+// C++ standard includes
+#include <algorithm>
+
+// Falltergeist includes
+#include "../Exception.h"
+#include "../Game/Game.h"
+#include "../Graphics/Renderer.h"
+#include "../Graphics/Texture.h"
+#include "../Logger.h"
+
+// Third party includes
+
+namespace Falltergeist
+{
+namespace Graphics
+{
+
+namespace
+{
+// Empty line between neighbours, so scaling never samples pixels of another texture
+const unsigned int PADDING = 1;
+// Page is reused only when none of its textures was drawn for that long (ms), so pages of visible sprites never thrash
+const unsigned int STALE_TIME = 2000;
+}
+
+TextureAtlas::TextureAtlas(SDL_Renderer* renderer, unsigned int pageSize, unsigned int maxPages)
+    : _renderer(renderer), _pageSize(pageSize), _maxPages(maxPages)
+{
+}
+
+TextureAtlas::~TextureAtlas()
+{
+    // Textures may outlive the atlas on shutdown
+    for (auto texture : _attached)
+    {
+        texture->_atlas = nullptr;
+        texture->_atlasPage = nullptr;
+    }
+    for (auto& page : _pages)
+    {
+        SDL_DestroyTexture(page.sdlTexture);
+    }
+}
+
+bool TextureAtlas::accepts(unsigned int width, unsigned int height) const
+{
+    return width > 0 && height > 0 && width <= _pageSize / 2 && height <= _pageSize / 2;
+}
+
+bool TextureAtlas::allocate(Texture* texture)
+{
+    unsigned int width = texture->width() + PADDING;
+    unsigned int height = texture->height() + PADDING;
+    unsigned int x = 0;
+    unsigned int y = 0;
+
+    Page* target = nullptr;
+    for (auto& page : _pages)
+    {
+        if (_place(page, width, height, x, y))
+        {
+            target = &page;
+            break;
+        }
+    }
+
+    if (!target && _pages.size() >= _maxPages)
+    {
+        target = _reclaim();
+        if (!target || !_place(*target, width, height, x, y)) return false;
+    }
+
+    if (!target)
+    {
+        auto sdlTexture = SDL_CreateTexture(_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, _pageSize, _pageSize);
+        if (!sdlTexture)
+        {
+            throw Exception("TextureAtlas::allocate() - " + std::string(SDL_GetError()));
+        }
+        SDL_SetTextureBlendMode(sdlTexture, SDL_BLENDMODE_BLEND);
+        _pages.push_back({sdlTexture, std::vector<Shelf>(), 0});
+        Logger::info("RENDERER") << "Texture atlas page " << _pages.size() << " created [" << _pageSize << "x" << _pageSize << "]" << std::endl;
+
+        target = &_pages.back();
+        if (!_place(*target, width, height, x, y)) return false;
+    }
+
+    texture->_atlasPage = target->sdlTexture;
+    texture->_atlasX = x;
+    texture->_atlasY = y;
+    _textures.insert(texture);
+    return true;
+}
+
+bool TextureAtlas::_place(Page& page, unsigned int width, unsigned int height, unsigned int& x, unsigned int& y)
+{
+    Shelf* best = nullptr;
+    for (auto& shelf : page.shelves)
+    {
+        if (shelf.height >= height && shelf.x + width <= _pageSize && (!best || shelf.height < best->height))
+        {
+            best = &shelf;
+        }
+    }
+
+    // Small sprites do not take place in tall shelves while there is room for a new one
+    if (best && best->height > height * 2 && page.top + height <= _pageSize)
+    {
+        best = nullptr;
+    }
+
+    if (!best)
+    {
+        if (page.top + height > _pageSize || width > _pageSize) return false;
+        page.shelves.push_back({page.top, height, 0});
+        page.top += height;
+        best = &page.shelves.back();
+    }
+
+    x = best->x;
+    y = best->y;
+    best->x += width;
+    return true;
+}
+
+TextureAtlas::Page* TextureAtlas::_reclaim()
+{
+    // Pages are not scanned for every texture that does not fit
+    auto ticks = SDL_GetTicks();
+    if (ticks < _nextReclaim) return nullptr;
+
+    // Page with the oldest last draw, pages without textures come first
+    std::vector<unsigned int> lastUsed(_pages.size(), 0);
+    std::vector<bool> queued(_pages.size(), false);
+    for (auto texture : _textures)
+    {
+        for (unsigned int i = 0; i != _pages.size(); ++i)
+        {
+            if (_pages.at(i).sdlTexture != texture->_atlasPage) continue;
+            lastUsed.at(i) = std::max(lastUsed.at(i), texture->_atlasUsed);
+            if (texture->_queued) queued.at(i) = true;
+            break;
+        }
+    }
+
+    Page* oldest = nullptr;
+    unsigned int oldestUsed = 0;
+    for (unsigned int i = 0; i != _pages.size(); ++i)
+    {
+        if (queued.at(i)) continue;
+        if (!oldest || lastUsed.at(i) < oldestUsed)
+        {
+            oldest = &_pages.at(i);
+            oldestUsed = lastUsed.at(i);
+        }
+    }
+    if (!oldest)
+    {
+        _nextReclaim = ticks + STALE_TIME / 4;
+        return nullptr;
+    }
+    if (oldestUsed + STALE_TIME > ticks)
+    {
+        _nextReclaim = oldestUsed + STALE_TIME;
+        return nullptr;
+    }
+
+    // Nothing queued refers to the page, its textures are placed again when they are drawn next time
+    for (auto it = _textures.begin(); it != _textures.end();)
+    {
+        if ((*it)->_atlasPage == oldest->sdlTexture)
+        {
+            (*it)->_atlasPage = nullptr;
+            it = _textures.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    oldest->shelves.clear();
+    oldest->top = 0;
+    _generation++;
+    return oldest;
+}
+
+void TextureAtlas::release(Texture* texture)
+{
+    if (!_textures.erase(texture)) return;
+
+    for (auto& page : _pages)
+    {
+        if (page.sdlTexture != texture->_atlasPage) continue;
+        for (auto& shelf : page.shelves)
+        {
+            if (shelf.y != texture->_atlasY || shelf.x != texture->_atlasX + texture->width() + PADDING) continue;
+            shelf.x = texture->_atlasX;
+            break;
+        }
+        while (!page.shelves.empty() && page.shelves.back().x == 0)
+        {
+            page.top = page.shelves.back().y;
+            page.shelves.pop_back();
+        }
+        break;
+    }
+    texture->_atlasPage = nullptr;
+}
+
+void TextureAtlas::attach(Texture* texture)
+{
+    _attached.insert(texture);
+}
+
+void TextureAtlas::detach(Texture* texture)
+{
+    release(texture);
+    _attached.erase(texture);
+}
+
+void TextureAtlas::clear()
+{
+    // Queued draw calls point to current places
+    Game::getInstance()->renderer()->flush();
+
+    for (auto texture : _textures)
+    {
+        texture->_atlasPage = nullptr;
+    }
+    _textures.clear();
+
+    for (auto& page : _pages)
+    {
+        page.shelves.clear();
+        page.top = 0;
+    }
+    _generation++;
+}
+
+unsigned int TextureAtlas::generation() const
+{
+    return _generation;
+}
+
+unsigned int TextureAtlas::pageSize() const
+{
+    return _pageSize;
+}
+
+unsigned int TextureAtlas::pages() const
+{
+    return _pages.size();
+}
+
+unsigned int TextureAtlas::size() const
+{
+    return _textures.size();
+}
+
+}
+}
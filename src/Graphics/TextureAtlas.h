@@ -0,0 +1,114 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FALLTERGEIST_GRAPHICS_TEXTUREATLAS_H
+#define FALLTERGEIST_GRAPHICS_TEXTUREATLAS_H
+
+// C++ standard includes
+#include <unordered_set>
+#include <vector>
+
+// Falltergeist includes
+
+// Third party includes
+#include <SDL.h>
+
+namespace Falltergeist
+{
+namespace Graphics
+{
+
+class Texture;
+
+/**
+ * @brief Shared SDL textures (pages) holding many small textures, so they can be drawn in one batch.
+ * Textures are placed with shelf packing when they are drawn for the first time.
+ * When all pages are full, a page nothing was drawn from for a while is emptied and reused.
+ */
+class TextureAtlas
+{
+public:
+    TextureAtlas(SDL_Renderer* renderer, unsigned int pageSize, unsigned int maxPages);
+    ~TextureAtlas();
+
+    /**
+     * Whether texture of given size should be placed into atlas at all.
+     */
+    bool accepts(unsigned int width, unsigned int height) const;
+    /**
+     * Finds place for texture, adding a new page or reusing a stale one if needed. Returns false when atlas is full.
+     */
+    bool allocate(Texture* texture);
+    /**
+     * Frees place of texture. Space at the end of its shelf is reused right away, the rest when the page is reused.
+     */
+    void release(Texture* texture);
+    /**
+     * Texture refers to the atlas, placed or not. Atlas clears the reference of every attached texture
+     * when it is destroyed before them.
+     */
+    void attach(Texture* texture);
+    void detach(Texture* texture);
+    /**
+     * Evicts all textures. Textures still in use are placed again when they are drawn next time.
+     */
+    void clear();
+    /**
+     * Changes whenever space is reclaimed, so textures that did not fit before may try again.
+     */
+    unsigned int generation() const;
+
+    unsigned int pageSize() const;
+    unsigned int pages() const;
+    unsigned int size() const;
+
+protected:
+    struct Shelf
+    {
+        unsigned int y;
+        unsigned int height;
+        unsigned int x; // free space starts here
+    };
+
+    struct Page
+    {
+        SDL_Texture* sdlTexture;
+        std::vector<Shelf> shelves;
+        unsigned int top; // free space below shelves starts here
+    };
+
+    SDL_Renderer* _renderer;
+    unsigned int _pageSize;
+    unsigned int _maxPages;
+    std::vector<Page> _pages;
+    // Placed textures
+    std::unordered_set<Texture*> _textures;
+    // All textures that refer to the atlas, evicted ones included
+    std::unordered_set<Texture*> _attached;
+    unsigned int _generation = 0;
+    // SDL ticks before which no page can be stale
+    unsigned int _nextReclaim = 0;
+
+    bool _place(Page& page, unsigned int width, unsigned int height, unsigned int& x, unsigned int& y);
+    Page* _reclaim();
+};
+
+}
+}
+#endif // FALLTERGEIST_GRAPHICS_TEXTUREATLAS_H
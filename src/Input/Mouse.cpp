@@ -21,12 +21,14 @@
 #include "../Input/Mouse.h"
 
 // C++ standard includes
+#include <algorithm>
 
 // Falltergeist includes
 #include "../Base/StlFeatures.h"
 #include "../Game/Game.h"
 #include "../Graphics/Renderer.h"
 #include "../Graphics/Texture.h"
+#include "../Logger.h"
 #include "../ResourceManager.h"
 #include "../Settings.h"
 #include "../UI/Animation.h"
@@ -34,6 +36,9 @@
 #include "../UI/Image.h"
 
 // Third party includes
+#include <libfalltergeist/Frm/Direction.h>
+#include <libfalltergeist/Frm/File.h>
+#include <libfalltergeist/Frm/Frame.h>
 #include <SDL.h>
 
 namespace Falltergeist
@@ -50,6 +55,7 @@ Mouse::Mouse()
 
 Mouse::~Mouse()
 {
+    _freeHardwareCursors();
     SDL_ShowCursor(1); // Show cursor
 }
 
@@ -126,87 +132,109 @@ void Mouse::_setType(Cursor state)
 {
     if (this->state() == state) return;
     _ui.reset(nullptr);
+    std::string frmName;
     switch (state)
     {
         case Cursor::BIG_ARROW:
-            _ui = make_unique<UI::Image>("art/intrface/stdarrow.frm");
+            frmName = "art/intrface/stdarrow.frm";
+            _ui = make_unique<UI::Image>(frmName);
             break;
         case Cursor::SCROLL_W:
-            _ui = make_unique<UI::Image>("art/intrface/scrwest.frm");
+            frmName = "art/intrface/scrwest.frm";
+            _ui = make_unique<UI::Image>(frmName);
             _ui->setOffset(0, -_ui->size().height() / 2);
             break;
         case Cursor::SCROLL_W_X:
-            _ui = make_unique<UI::Image>("art/intrface/scrwx.frm");
+            frmName = "art/intrface/scrwx.frm";
+            _ui = make_unique<UI::Image>(frmName);
             _ui->setOffset(0, -_ui->size().height() / 2);
             break;
         case Cursor::SCROLL_N:
-            _ui = make_unique<UI::Image>("art/intrface/scrnorth.frm");
+            frmName = "art/intrface/scrnorth.frm";
+            _ui = make_unique<UI::Image>(frmName);
             _ui->setOffset( -_ui->size().width() / 2, 0);
             break;
         case Cursor::SCROLL_N_X:
-            _ui = make_unique<UI::Image>("art/intrface/scrnx.frm");
+            frmName = "art/intrface/scrnx.frm";
+            _ui = make_unique<UI::Image>(frmName);
             _ui->setOffset( -_ui->size().width() / 2, 0);
             break;
         case Cursor::SCROLL_S:
-            _ui = make_unique<UI::Image>("art/intrface/scrsouth.frm");
+            frmName = "art/intrface/scrsouth.frm";
+            _ui = make_unique<UI::Image>(frmName);
             _ui->setOffset( -_ui->size().width() / 2, -_ui->size().height());
             break;
         case Cursor::SCROLL_S_X:
-            _ui = make_unique<UI::Image>("art/intrface/scrsx.frm");
+            frmName = "art/intrface/scrsx.frm";
+            _ui = make_unique<UI::Image>(frmName);
             _ui->setOffset(-_ui->size().width() / 2, -_ui->size().height());
             break;
         case Cursor::SCROLL_E:
-            _ui = make_unique<UI::Image>("art/intrface/screast.frm");
+            frmName = "art/intrface/screast.frm";
+            _ui = make_unique<UI::Image>(frmName);
             _ui->setOffset( -_ui->size().width(), -_ui->size().height() / 2);
             break;
         case Cursor::SCROLL_E_X:
-            _ui = make_unique<UI::Image>("art/intrface/screx.frm");
+            frmName = "art/intrface/screx.frm";
+            _ui = make_unique<UI::Image>(frmName);
             _ui->setOffset(-_ui->size().width(), -_ui->size().height() / 2);
             break;
         case Cursor::SCROLL_NW:
-            _ui = make_unique<UI::Image>("art/intrface/scrnwest.frm");
+            frmName = "art/intrface/scrnwest.frm";
+            _ui = make_unique<UI::Image>(frmName);
             break;
         case Cursor::SCROLL_NW_X:
-            _ui = make_unique<UI::Image>("art/intrface/scrnwx.frm");
+            frmName = "art/intrface/scrnwx.frm";
+            _ui = make_unique<UI::Image>(frmName);
             break;
         case Cursor::SCROLL_SW:
-            _ui = make_unique<UI::Image>("art/intrface/scrswest.frm");
+            frmName = "art/intrface/scrswest.frm";
+            _ui = make_unique<UI::Image>(frmName);
             _ui->setOffset(0, -_ui->size().height());
             break;
         case Cursor::SCROLL_SW_X:
-            _ui = make_unique<UI::Image>("art/intrface/scrswx.frm");
+            frmName = "art/intrface/scrswx.frm";
+            _ui = make_unique<UI::Image>(frmName);
             _ui->setOffset(0, -_ui->size().height());
             break;
         case Cursor::SCROLL_NE:
-            _ui = make_unique<UI::Image>("art/intrface/scrneast.frm");
+            frmName = "art/intrface/scrneast.frm";
+            _ui = make_unique<UI::Image>(frmName);
             _ui->setOffset(-_ui->size().width(), 0);
             break;
         case Cursor::SCROLL_NE_X:
-            _ui = make_unique<UI::Image>("art/intrface/scrnex.frm");
+            frmName = "art/intrface/scrnex.frm";
+            _ui = make_unique<UI::Image>(frmName);
             _ui->setOffset(-_ui->size().width(), 0);
             break;
         case Cursor::SCROLL_SE:
-            _ui = make_unique<UI::Image>("art/intrface/scrseast.frm");
+            frmName = "art/intrface/scrseast.frm";
+            _ui = make_unique<UI::Image>(frmName);
             _ui->setOffset(-_ui->size().width(), -_ui->size().height());
             break;
         case Cursor::SCROLL_SE_X:
-            _ui = make_unique<UI::Image>("art/intrface/scrsex.frm");
+            frmName = "art/intrface/scrsex.frm";
+            _ui = make_unique<UI::Image>(frmName);
             _ui->setOffset(-_ui->size().width(), -_ui->size().height());
             break;
         case Cursor::HEXAGON_RED:
-            _ui = make_unique<UI::Image>("art/intrface/msef000.frm");
+            frmName = "art/intrface/msef000.frm";
+            _ui = make_unique<UI::Image>(frmName);
             _ui->setOffset(- _ui->size().width() / 2, - _ui->size().height() / 2);
             break;
         case Cursor::ACTION:
-            _ui = make_unique<UI::Image>("art/intrface/actarrow.frm");
+            frmName = "art/intrface/actarrow.frm";
+            _ui = make_unique<UI::Image>(frmName);
             break;
         case Cursor::HAND:
-            _ui = make_unique<UI::Image>("art/intrface/hand.frm");
+            frmName = "art/intrface/hand.frm";
+            _ui = make_unique<UI::Image>(frmName);
             break;
         case Cursor::WAIT:
         {
             auto queue = make_unique<UI::AnimationQueue>();
-            queue->animations().push_back(make_unique<UI::Animation>("art/intrface/wait.frm"));
+            frmName = "art/intrface/wait.frm";
+            queue->animations().push_back(make_unique<UI::Animation>(frmName));
             queue->setRepeat(true);
             queue->start();
             _ui = std::move(queue);
@@ -218,13 +246,130 @@ void Mouse::_setType(Cursor state)
         default:
             break;
     }
+    _setHardwareCursor(state, frmName);
+}
+
+void Mouse::_setHardwareCursor(Cursor state, const std::string& frmName)
+{
+    // Red hexagon snaps to the hex grid, so it can't follow the pointer on its own
+    if (!_ui || state == Cursor::HEXAGON_RED)
+    {
+        _hardwareCursor = nullptr;
+        SDL_ShowCursor(0);
+        return;
+    }
+
+    auto renderer = Game::getInstance()->renderer();
+    if (renderer->scaleX() != _hardwareCursorScaleX || renderer->scaleY() != _hardwareCursorScaleY)
+    {
+        _freeHardwareCursors();
+        _hardwareCursorScaleX = renderer->scaleX();
+        _hardwareCursorScaleY = renderer->scaleY();
+    }
+
+    auto it = _hardwareCursors.find(state);
+    if (it == _hardwareCursors.end())
+    {
+        it = _hardwareCursors.insert(std::make_pair(state, _createHardwareCursors(frmName, state == Cursor::WAIT))).first;
+    }
+
+    // Falls back to render() if system cursor can't be created
+    _hardwareCursor = it->second.empty() ? nullptr : it->second.front();
+    if (_hardwareCursor)
+    {
+        SDL_SetCursor(_hardwareCursor);
+    }
+    SDL_ShowCursor(_hardwareCursor ? 1 : 0);
+}
+
+std::vector<SDL_Cursor*> Mouse::_createHardwareCursors(const std::string& frmName, bool centered)
+{
+    std::vector<SDL_Cursor*> cursors;
+    auto frm = ResourceManager::getInstance()->frmFileType(frmName);
+    if (!frm) return cursors;
+
+    Uint32 rmask, gmask, bmask, amask;
+    #if SDL_BYTEORDER != SDL_BIG_ENDIAN
+        rmask = 0xff000000;
+        gmask = 0x00ff0000;
+        bmask = 0x0000ff00;
+        amask = 0x000000ff;
+    #else
+        rmask = 0x000000ff;
+        gmask = 0x0000ff00;
+        bmask = 0x00ff0000;
+        amask = 0xff000000;
+    #endif
+
+    unsigned int* rgba = frm->rgba(ResourceManager::getInstance()->palFileType("color.pal"));
+    float scaleX = _hardwareCursorScaleX;
+    float scaleY = _hardwareCursorScaleY;
+
+    // Frames of the first direction lie in a row
+    unsigned int frameX = 0;
+    auto frames = frm->directions()->at(0)->frames();
+    for (auto frame : *frames)
+    {
+        // System cursor is not scaled with the renderer, so it is scaled here
+        int width = std::max(1, (int)(frame->width() * scaleX));
+        int height = std::max(1, (int)(frame->height() * scaleY));
+        SDL_Surface* surface = SDL_CreateRGBSurface(0, width, height, 32, rmask, gmask, bmask, amask);
+        if (!surface) break;
+
+        for (int y = 0; y != height; ++y)
+        {
+            unsigned int* row = (unsigned int*)((char*)surface->pixels + y * surface->pitch);
+            unsigned int* source = rgba + (unsigned int)(y / scaleY) * frm->width() + frameX;
+            for (int x = 0; x != width; ++x)
+            {
+                row[x] = source[(unsigned int)(x / scaleX)];
+            }
+        }
+
+        Point hotSpot = centered ? Point(frame->width() / 2, frame->height() / 2) : Point() - _ui->offset();
+        SDL_Cursor* cursor = SDL_CreateColorCursor(surface, (int)(hotSpot.x() * scaleX), (int)(hotSpot.y() * scaleY));
+        SDL_FreeSurface(surface);
+        if (!cursor)
+        {
+            Logger::warning("MOUSE") << "Can't create cursor from " << frmName << ": " << SDL_GetError() << std::endl;
+            break;
+        }
+        cursors.push_back(cursor);
+        frameX += frame->width();
+    }
+
+    // Animated cursor is either complete or not used at all
+    if (cursors.size() != frames->size())
+    {
+        for (auto cursor : cursors)
+        {
+            SDL_FreeCursor(cursor);
+        }
+        cursors.clear();
+    }
+    return cursors;
+}
+
+void Mouse::_freeHardwareCursors()
+{
+    // SDL falls back to default cursor when the current one is freed
+    for (auto& it : _hardwareCursors)
+    {
+        for (auto cursor : it.second)
+        {
+            SDL_FreeCursor(cursor);
+        }
+    }
+    _hardwareCursors.clear();
+    _hardwareCursor = nullptr;
 }
 
 void Mouse::render()
 {
     if (state() == Cursor::NONE) return;
 
-    if (_ui)
+    // System cursor is drawn by SDL
+    if (_ui && !_hardwareCursor)
     {
         if (state() != Cursor::HEXAGON_RED)
         {
@@ -243,6 +388,19 @@ void Mouse::think()
     {
         _ui->think();
     }
+
+    // Animated system cursor follows its animation
+    auto queue = dynamic_cast<UI::AnimationQueue*>(_ui.get());
+    if (_hardwareCursor && queue && queue->currentAnimation())
+    {
+        auto& cursors = _hardwareCursors.at(state());
+        auto frame = queue->currentAnimation()->currentFrame();
+        if (frame < cursors.size() && cursors.at(frame) != _hardwareCursor)
+        {
+            _hardwareCursor = cursors.at(frame);
+            SDL_SetCursor(_hardwareCursor);
+        }
+    }
 }
 
 bool Mouse::scrollState()
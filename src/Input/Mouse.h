@@ -21,7 +21,9 @@
 #define FALLTERGEIST_INPUT_MOUSE_H
 
 // C++ standard includes
+#include <map>
 #include <memory>
+#include <string>
 #include <vector>
 
 // Falltergeist includes
@@ -29,6 +31,8 @@
 
 // Third party includes
 
+struct SDL_Cursor;
+
 namespace Falltergeist
 {
 namespace UI
@@ -117,7 +121,16 @@ protected:
     Cursor _type = Cursor::NONE;
     std::vector<Cursor> _states;
     std::unique_ptr<UI::Base> _ui;
+    // System cursors made of FRM frames, they follow the pointer without waiting for the next frame to render
+    std::map<Cursor, std::vector<SDL_Cursor*>> _hardwareCursors;
+    float _hardwareCursorScaleX = 0;
+    float _hardwareCursorScaleY = 0;
+    // nullptr when cursor is drawn by render()
+    SDL_Cursor* _hardwareCursor = nullptr;
     void _setType(Cursor type);
+    void _setHardwareCursor(Cursor type, const std::string& frmName);
+    std::vector<SDL_Cursor*> _createHardwareCursors(const std::string& frmName, bool centered);
+    void _freeHardwareCursors();
 };
 
 }
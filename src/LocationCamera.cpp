@@ -20,6 +20,8 @@
 // C++ includes
 
 // Falltergeist includes
+#include "Game/Clock.h"
+#include "Game/Game.h"
 #include "LocationCamera.h"
 #include "Logger.h"
 
@@ -41,7 +43,8 @@ LocationCamera::~LocationCamera()
 
 Point LocationCamera::topLeft() const
 {
-    return _center - (_size / 2.0);
+    auto center = _previousCenter + (_center - _previousCenter) * Game::getInstance()->clock()->alpha();
+    return center - (_size / 2.0);
 }
 
 const Point& LocationCamera::center() const
@@ -60,6 +63,19 @@ void LocationCamera::setCenter(const Point& pos)
     {
         _center.setY(_size.height() / 2);
     }
+    _previousCenter = _center;
+}
+
+void LocationCamera::scroll(const Point& offset)
+{
+    auto previousCenter = _previousCenter;
+    setCenter(_center + offset);
+    _previousCenter = previousCenter;
+}
+
+void LocationCamera::think()
+{
+    _previousCenter = _center;
 }
 
 const Size& LocationCamera::size() const
@@ -34,16 +34,32 @@ class LocationCamera
 {
 protected:
     Point _center;
+    // Center before the current simulation step
+    Point _previousCenter;
     Size _size;
 
 public:
     LocationCamera(const Size& size, const Point& center);
     ~LocationCamera();
 
+    /**
+     * Top left corner of the view, interpolated between the last two simulation steps.
+     */
     Point topLeft() const;
 
     const Point& center() const;
+    /**
+     * Moves camera at once, without interpolation.
+     */
     void setCenter(const Point& pos);
+    /**
+     * Moves camera within current simulation step, the move is interpolated when rendering.
+     */
+    void scroll(const Point& offset);
+    /**
+     * Starts new simulation step.
+     */
+    void think();
 
     const Size& size() const;
     void setSize(const Size& size);
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Related headers
+#include "../Pack/File.h"
+
+// C++ standard includes
+#include <cstring>
+
+// Falltergeist includes
+#include "../Exception.h"
+
+// Third party includes
+#include <zlib.h>
+
+namespace Falltergeist
+{
+namespace Pack
+{
+
+File::File(const std::string& filename) : _filename(filename)
+{
+    _stream.open(filename, std::ios_base::binary);
+    if (!_stream.is_open())
+    {
+        throw Exception("Pack::File::File() - can't open pack: " + filename);
+    }
+
+    unsigned char header[HEADER_SIZE];
+    _read((char*)header, 0, HEADER_SIZE);
+    if (memcmp(header, MAGIC, sizeof(MAGIC)) != 0 || readUInt32(header + 4) != VERSION)
+    {
+        throw Exception("Pack::File::File() - wrong pack format: " + filename);
+    }
+
+    uint32_t entryCount = readUInt32(header + 8);
+    _bucketCount = readUInt32(header + 12);
+    uint64_t seedsOffset = readUInt64(header + 16);
+    uint64_t entriesOffset = readUInt64(header + 24);
+    uint64_t namesOffset = readUInt64(header + 32);
+    uint32_t namesSize = readUInt32(header + 40);
+
+    if (entryCount == 0 || _bucketCount != bucketCount(entryCount))
+    {
+        throw Exception("Pack::File::File() - wrong pack directory: " + filename);
+    }
+
+    std::vector<unsigned char> seeds(_bucketCount * 4);
+    _read((char*)seeds.data(), seedsOffset, seeds.size());
+    _seeds.resize(_bucketCount);
+    for (uint32_t i = 0; i != _bucketCount; ++i)
+    {
+        _seeds[i] = readUInt32(seeds.data() + i * 4);
+    }
+
+    std::vector<unsigned char> entries((uint64_t)entryCount * ENTRY_SIZE);
+    _read((char*)entries.data(), entriesOffset, entries.size());
+    _entries.resize(entryCount);
+    for (uint32_t i = 0; i != entryCount; ++i)
+    {
+        const unsigned char* data = entries.data() + (uint64_t)i * ENTRY_SIZE;
+        Entry& entry = _entries[i];
+        entry.offset      = readUInt64(data);
+        entry.packedSize  = readUInt32(data + 8);
+        entry.size        = readUInt32(data + 12);
+        entry.hash        = readUInt64(data + 16);
+        entry.nameOffset  = readUInt32(data + 24);
+        entry.nameLength  = readUInt16(data + 28);
+        entry.compression = (COMPRESSION)data[30];
+        entry.kind        = (KIND)data[31];
+    }
+
+    _names.resize(namesSize);
+    _read(&_names[0], namesOffset, namesSize);
+}
+
+File::~File()
+{
+}
+
+std::string File::filename() const
+{
+    return _filename;
+}
+
+unsigned int File::size() const
+{
+    return _entries.size();
+}
+
+const Entry* File::entry(const std::string& name) const
+{
+    uint64_t nameHash = hash(name);
+    uint32_t seed = _seeds[nameHash % _bucketCount];
+    const Entry& entry = _entries[slot(nameHash, seed, _entries.size())];
+
+    if (entry.hash != nameHash || entry.nameLength != name.length()) return nullptr;
+    if (_names.compare(entry.nameOffset, entry.nameLength, name) != 0) return nullptr;
+    return &entry;
+}
+
+std::vector<char> File::data(const Entry* entry)
+{
+    std::vector<char> packed(entry->packedSize);
+    _read(packed.data(), entry->offset, entry->packedSize);
+
+    if (entry->compression == COMPRESSION::NONE)
+    {
+        return packed;
+    }
+
+    std::vector<char> data(entry->size);
+    uLongf size = entry->size;
+    if (uncompress((Bytef*)data.data(), &size, (const Bytef*)packed.data(), entry->packedSize) != Z_OK || size != entry->size)
+    {
+        throw Exception("Pack::File::data() - can't inflate entry: " + _names.substr(entry->nameOffset, entry->nameLength));
+    }
+    return data;
+}
+
+void File::_read(char* destination, uint64_t offset, uint64_t size)
+{
+    _stream.clear();
+    _stream.seekg(offset, std::ios_base::beg);
+    _stream.read(destination, size);
+    if ((uint64_t)_stream.gcount() != size)
+    {
+        throw Exception("Pack::File::_read() - unexpected end of pack: " + _filename);
+    }
+}
+
+}
+}
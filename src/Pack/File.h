@@ -0,0 +1,68 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FALLTERGEIST_PACK_FILE_H
+#define FALLTERGEIST_PACK_FILE_H
+
+// C++ standard includes
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Falltergeist includes
+#include "../Pack/Format.h"
+
+// Third party includes
+
+namespace Falltergeist
+{
+namespace Pack
+{
+
+/**
+ * @brief Read-only access to a pack produced by falltergeist-packer.
+ * Only the directory is read when the pack is mounted, payloads are read on request.
+ */
+class File
+{
+public:
+    File(const std::string& filename);
+    ~File();
+
+    std::string filename() const;
+    unsigned int size() const;
+
+    const Entry* entry(const std::string& name) const;
+    std::vector<char> data(const Entry* entry);
+
+protected:
+    std::string _filename;
+    std::ifstream _stream;
+    uint32_t _bucketCount = 0;
+    std::vector<uint32_t> _seeds;
+    std::vector<Entry> _entries;
+    std::string _names;
+
+    void _read(char* destination, uint64_t offset, uint64_t size);
+};
+
+}
+}
+#endif // FALLTERGEIST_PACK_FILE_H
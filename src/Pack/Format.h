@@ -0,0 +1,151 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FALLTERGEIST_PACK_FORMAT_H
+#define FALLTERGEIST_PACK_FORMAT_H
+
+// C++ standard includes
+#include <cstdint>
+#include <string>
+
+// Falltergeist includes
+
+// Third party includes
+
+/*
+ * Pack file layout (all numbers are little-endian):
+ *
+ *  [header]     64 bytes, see HEADER_SIZE
+ *  [data]       entry payloads, each one starts at a 64-byte boundary
+ *  [seeds]      uint32 displacement per bucket of the perfect hash
+ *  [entries]    ENTRY_SIZE bytes per entry, stored in slot order
+ *  [names]      entry names, not null-terminated
+ *
+ * Lookup: bucket = hash % bucketCount, slot = slot(hash, seeds[bucket], entryCount).
+ * Every name maps to exactly one slot, so a lookup is one probe and one name comparison.
+ */
+
+namespace Falltergeist
+{
+namespace Pack
+{
+
+const char MAGIC[4] = {'F', 'G', 'P', 'K'};
+const uint32_t VERSION = 1;
+const uint32_t HEADER_SIZE = 64;
+const uint32_t ENTRY_SIZE = 32;
+const uint32_t ALIGNMENT = 64;
+
+// Texture entries are stored next to source files under "<filename>" + TEXTURE_SUFFIX
+const std::string TEXTURE_SUFFIX = ":rgba";
+
+enum class COMPRESSION : uint8_t
+{
+    NONE = 0,
+    ZLIB
+};
+
+enum class KIND : uint8_t
+{
+    FILE = 0,   // file contents as they are stored in DAT or data directory
+    TEXTURE     // uint32 width, uint32 height, width * height RGBA pixels
+};
+
+struct Entry
+{
+    uint64_t offset = 0;
+    uint32_t packedSize = 0;
+    uint32_t size = 0;
+    uint64_t hash = 0;
+    uint32_t nameOffset = 0;
+    uint16_t nameLength = 0;
+    COMPRESSION compression = COMPRESSION::NONE;
+    KIND kind = KIND::FILE;
+};
+
+// 64-bit FNV-1a
+inline uint64_t hash(const std::string& name)
+{
+    uint64_t result = 0xcbf29ce484222325ULL;
+    for (unsigned char c : name)
+    {
+        result ^= c;
+        result *= 0x100000001b3ULL;
+    }
+    return result;
+}
+
+inline uint32_t slot(uint64_t hash, uint32_t seed, uint32_t entryCount)
+{
+    uint64_t x = hash ^ (seed * 0x9e3779b97f4a7c15ULL);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    x = x ^ (x >> 31);
+    return (uint32_t)(x % entryCount);
+}
+
+inline uint32_t bucketCount(uint32_t entryCount)
+{
+    return entryCount / 4 + 1;
+}
+
+inline uint64_t align(uint64_t offset)
+{
+    return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+// Little-endian numbers, independent of host byte order and alignment
+inline uint16_t readUInt16(const unsigned char* data)
+{
+    return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+inline uint32_t readUInt32(const unsigned char* data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+inline uint64_t readUInt64(const unsigned char* data)
+{
+    return (uint64_t)readUInt32(data) | ((uint64_t)readUInt32(data + 4) << 32);
+}
+
+inline void writeUInt16(unsigned char* data, uint16_t value)
+{
+    data[0] = value & 0xff;
+    data[1] = (value >> 8) & 0xff;
+}
+
+inline void writeUInt32(unsigned char* data, uint32_t value)
+{
+    for (unsigned int i = 0; i != 4; ++i)
+    {
+        data[i] = (value >> (i * 8)) & 0xff;
+    }
+}
+
+inline void writeUInt64(unsigned char* data, uint64_t value)
+{
+    writeUInt32(data, (uint32_t)value);
+    writeUInt32(data + 4, (uint32_t)(value >> 32));
+}
+
+}
+}
+#endif // FALLTERGEIST_PACK_FORMAT_H
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Related headers
+#include "../Pack/StreamBuffer.h"
+
+// C++ standard includes
+
+// Falltergeist includes
+
+// Third party includes
+
+namespace Falltergeist
+{
+namespace Pack
+{
+
+StreamBuffer::StreamBuffer(std::vector<char>&& data) : _data(std::move(data))
+{
+    char* begin = _data.data();
+    setg(begin, begin, begin + _data.size());
+}
+
+StreamBuffer::~StreamBuffer()
+{
+}
+
+void StreamBuffer::attach(std::ifstream& stream)
+{
+    static_cast<std::ios&>(stream).rdbuf(this);
+}
+
+StreamBuffer::pos_type StreamBuffer::seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode mode)
+{
+    if (!(mode & std::ios_base::in)) return pos_type(off_type(-1));
+
+    off_type position;
+    switch (direction)
+    {
+        case std::ios_base::beg:
+            position = offset;
+            break;
+        case std::ios_base::cur:
+            position = (gptr() - eback()) + offset;
+            break;
+        case std::ios_base::end:
+            position = (off_type)_data.size() + offset;
+            break;
+        default:
+            return pos_type(off_type(-1));
+    }
+    return seekpos(pos_type(position), mode);
+}
+
+StreamBuffer::pos_type StreamBuffer::seekpos(pos_type position, std::ios_base::openmode mode)
+{
+    off_type offset = position;
+    if (!(mode & std::ios_base::in) || offset < 0 || offset > (off_type)_data.size())
+    {
+        return pos_type(off_type(-1));
+    }
+    setg(eback(), eback() + offset, egptr());
+    return position;
+}
+
+}
+}
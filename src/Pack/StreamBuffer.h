@@ -0,0 +1,59 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FALLTERGEIST_PACK_STREAMBUFFER_H
+#define FALLTERGEIST_PACK_STREAMBUFFER_H
+
+// C++ standard includes
+#include <fstream>
+#include <streambuf>
+#include <vector>
+
+// Falltergeist includes
+
+// Third party includes
+
+namespace Falltergeist
+{
+namespace Pack
+{
+
+/**
+ * @brief Seekable read-only stream buffer over data held in memory.
+ * libfalltergeist file types are constructed from std::ifstream, so attach() lets
+ * an unopened ifstream read from this buffer instead of a file on disk.
+ */
+class StreamBuffer : public std::streambuf
+{
+public:
+    StreamBuffer(std::vector<char>&& data);
+    ~StreamBuffer();
+
+    void attach(std::ifstream& stream);
+
+protected:
+    std::vector<char> _data;
+
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode mode = std::ios_base::in) override;
+    pos_type seekpos(pos_type position, std::ios_base::openmode mode = std::ios_base::in) override;
+};
+
+}
+}
+#endif // FALLTERGEIST_PACK_STREAMBUFFER_H
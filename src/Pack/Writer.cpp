@@ -0,0 +1,290 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Related headers
+#include "../Pack/Writer.h"
+
+// C++ standard includes
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+// Falltergeist includes
+#include "../Exception.h"
+
+// Third party includes
+#include <zlib.h>
+
+namespace Falltergeist
+{
+namespace Pack
+{
+
+namespace
+{
+// Entries smaller than this are always stored raw
+const uint32_t MIN_COMPRESSED_SIZE = 256;
+
+// Perfect hash seed search gives up after this many attempts per bucket
+const uint32_t MAX_SEED = 1 << 24;
+}
+
+Writer::Writer(const std::string& filename) : _filename(filename)
+{
+    _stream.open(filename, std::ios_base::binary | std::ios_base::trunc);
+    if (!_stream.is_open())
+    {
+        throw Exception("Pack::Writer::Writer() - can't create pack: " + filename);
+    }
+
+    // Header is rewritten by finish()
+    unsigned char header[HEADER_SIZE] = {};
+    _write(header, HEADER_SIZE);
+}
+
+Writer::~Writer()
+{
+}
+
+bool Writer::contains(const std::string& name) const
+{
+    return _entryNames.find(name) != _entryNames.end();
+}
+
+void Writer::add(const std::string& name, const std::vector<char>& data, KIND kind)
+{
+    if (_finished)
+    {
+        throw Exception("Pack::Writer::add() - pack is already finished: " + _filename);
+    }
+    if (contains(name))
+    {
+        throw Exception("Pack::Writer::add() - duplicate entry: " + name);
+    }
+    if (name.length() > 0xffff)
+    {
+        throw Exception("Pack::Writer::add() - entry name is too long: " + name);
+    }
+
+    Entry entry;
+    entry.hash = hash(name);
+    entry.kind = kind;
+    entry.size = data.size();
+    entry.nameOffset = _names.size();
+    entry.nameLength = name.length();
+
+    // Inflating is cheap, so compression is kept only when it saves a noticeable amount of I/O.
+    // Inflate speed hardly depends on the level deflate used, so the best level is taken: it costs
+    // pack build time only and gives smaller entries, i.e. less I/O on every load
+    std::vector<char> packed;
+    if (data.size() >= MIN_COMPRESSED_SIZE)
+    {
+        uLongf packedSize = compressBound(data.size());
+        packed.resize(packedSize);
+        if (compress2((Bytef*)packed.data(), &packedSize, (const Bytef*)data.data(), data.size(), Z_BEST_COMPRESSION) == Z_OK
+            && packedSize <= data.size() - data.size() / 8)
+        {
+            packed.resize(packedSize);
+            entry.compression = COMPRESSION::ZLIB;
+        }
+    }
+
+    _pad();
+    entry.offset = _offset;
+    if (entry.compression == COMPRESSION::ZLIB)
+    {
+        entry.packedSize = packed.size();
+        _write(packed.data(), packed.size());
+    }
+    else
+    {
+        entry.packedSize = data.size();
+        _write(data.data(), data.size());
+    }
+
+    _names += name;
+    _entryNames.insert(name);
+    _entries.push_back(entry);
+}
+
+void Writer::finish()
+{
+    if (_finished) return;
+    if (_entries.empty())
+    {
+        throw Exception("Pack::Writer::finish() - pack is empty: " + _filename);
+    }
+
+    std::vector<Entry> slots;
+    auto seeds = _buildDirectory(slots);
+
+    _pad();
+    uint64_t seedsOffset = _offset;
+    for (auto seed : seeds)
+    {
+        unsigned char data[4];
+        writeUInt32(data, seed);
+        _write(data, 4);
+    }
+
+    _pad();
+    uint64_t entriesOffset = _offset;
+    for (auto& entry : slots)
+    {
+        unsigned char data[ENTRY_SIZE];
+        writeUInt64(data, entry.offset);
+        writeUInt32(data + 8, entry.packedSize);
+        writeUInt32(data + 12, entry.size);
+        writeUInt64(data + 16, entry.hash);
+        writeUInt32(data + 24, entry.nameOffset);
+        writeUInt16(data + 28, entry.nameLength);
+        data[30] = (unsigned char)entry.compression;
+        data[31] = (unsigned char)entry.kind;
+        _write(data, ENTRY_SIZE);
+    }
+
+    uint64_t namesOffset = _offset;
+    _write(_names.data(), _names.size());
+
+    unsigned char header[HEADER_SIZE] = {};
+    memcpy(header, MAGIC, sizeof(MAGIC));
+    writeUInt32(header + 4, VERSION);
+    writeUInt32(header + 8, slots.size());
+    writeUInt32(header + 12, seeds.size());
+    writeUInt64(header + 16, seedsOffset);
+    writeUInt64(header + 24, entriesOffset);
+    writeUInt64(header + 32, namesOffset);
+    writeUInt32(header + 40, _names.size());
+    _stream.seekp(0, std::ios_base::beg);
+    _stream.write((const char*)header, HEADER_SIZE);
+    _stream.close();
+
+    if (_stream.fail())
+    {
+        throw Exception("Pack::Writer::finish() - can't write pack: " + _filename);
+    }
+    _finished = true;
+}
+
+unsigned int Writer::size() const
+{
+    return _entries.size();
+}
+
+uint64_t Writer::bytesWritten() const
+{
+    return _offset;
+}
+
+void Writer::_write(const void* data, uint64_t size)
+{
+    _stream.write((const char*)data, size);
+    if (_stream.fail())
+    {
+        throw Exception("Pack::Writer::_write() - can't write pack: " + _filename);
+    }
+    _offset += size;
+}
+
+void Writer::_pad()
+{
+    static const char zeros[ALIGNMENT] = {};
+    _write(zeros, align(_offset) - _offset);
+}
+
+// Hash and displace: names are split into buckets, then buckets are placed from the largest
+// to the smallest, each one with the first seed that moves all its names to free slots.
+std::vector<uint32_t> Writer::_buildDirectory(std::vector<Entry>& slots)
+{
+    uint32_t entryCount = _entries.size();
+    uint32_t buckets = bucketCount(entryCount);
+
+    std::unordered_map<uint64_t, uint32_t> hashes;
+    for (uint32_t i = 0; i != entryCount; ++i)
+    {
+        if (!hashes.insert(std::make_pair(_entries[i].hash, i)).second)
+        {
+            throw Exception("Pack::Writer::_buildDirectory() - hash collision: "
+                            + _names.substr(_entries[i].nameOffset, _entries[i].nameLength));
+        }
+    }
+
+    std::vector<std::vector<uint32_t>> bucketEntries(buckets);
+    for (uint32_t i = 0; i != entryCount; ++i)
+    {
+        bucketEntries[_entries[i].hash % buckets].push_back(i);
+    }
+
+    std::vector<uint32_t> order(buckets);
+    for (uint32_t i = 0; i != buckets; ++i)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&bucketEntries](uint32_t a, uint32_t b)
+    {
+        return bucketEntries[a].size() > bucketEntries[b].size();
+    });
+
+    std::vector<uint32_t> seeds(buckets, 0);
+    std::vector<bool> taken(entryCount, false);
+    std::vector<uint32_t> candidates;
+    for (auto bucket : order)
+    {
+        auto& indexes = bucketEntries[bucket];
+        if (indexes.empty()) break;
+
+        uint32_t seed = 0;
+        for (; seed != MAX_SEED; ++seed)
+        {
+            candidates.clear();
+            bool fits = true;
+            for (auto index : indexes)
+            {
+                uint32_t position = slot(_entries[index].hash, seed, entryCount);
+                if (taken[position] || std::find(candidates.begin(), candidates.end(), position) != candidates.end())
+                {
+                    fits = false;
+                    break;
+                }
+                candidates.push_back(position);
+            }
+            if (fits) break;
+        }
+        if (seed == MAX_SEED)
+        {
+            throw Exception("Pack::Writer::_buildDirectory() - can't build perfect hash for " + std::to_string(entryCount) + " entries");
+        }
+
+        seeds[bucket] = seed;
+        for (auto position : candidates)
+        {
+            taken[position] = true;
+        }
+    }
+
+    slots.resize(entryCount);
+    for (auto& entry : _entries)
+    {
+        slots[slot(entry.hash, seeds[entry.hash % buckets], entryCount)] = entry;
+    }
+    return seeds;
+}
+
+}
+}
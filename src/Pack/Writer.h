@@ -0,0 +1,73 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FALLTERGEIST_PACK_WRITER_H
+#define FALLTERGEIST_PACK_WRITER_H
+
+// C++ standard includes
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Falltergeist includes
+#include "../Pack/Format.h"
+
+// Third party includes
+
+namespace Falltergeist
+{
+namespace Pack
+{
+
+/**
+ * @brief Writes a pack file.
+ * Payloads are streamed to disk as they are added, the directory is written by finish().
+ */
+class Writer
+{
+public:
+    Writer(const std::string& filename);
+    ~Writer();
+
+    bool contains(const std::string& name) const;
+    void add(const std::string& name, const std::vector<char>& data, KIND kind = KIND::FILE);
+    void finish();
+
+    unsigned int size() const;
+    uint64_t bytesWritten() const;
+
+protected:
+    std::string _filename;
+    std::ofstream _stream;
+    uint64_t _offset = 0;
+    std::vector<Entry> _entries;
+    std::unordered_set<std::string> _entryNames;
+    std::string _names;
+    bool _finished = false;
+
+    void _write(const void* data, uint64_t size);
+    void _pad();
+    std::vector<uint32_t> _buildDirectory(std::vector<Entry>& slots);
+};
+
+}
+}
+#endif // FALLTERGEIST_PACK_WRITER_H
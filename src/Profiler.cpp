@@ -0,0 +1,196 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Related headers
+#include "Profiler.h"
+
+// C++ standard includes
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+// Falltergeist includes
+
+// Third party includes
+
+namespace Falltergeist
+{
+
+struct Profiler::Thread
+{
+    std::mutex mutex;
+    unsigned int id = 0;
+    std::string name;
+    // Ring buffer, count is the number of samples ever recorded
+    std::vector<Sample> samples;
+    uint64_t count = 0;
+};
+
+const unsigned int Profiler::SAMPLES_PER_THREAD = 65536;
+const unsigned int Profiler::FRAMES = 120;
+
+std::atomic<bool> Profiler::_enabled(false);
+std::mutex Profiler::_threadsMutex;
+std::vector<std::unique_ptr<Profiler::Thread>> Profiler::_threads;
+std::vector<uint64_t> Profiler::_frames;
+uint64_t Profiler::_frameCount = 0;
+
+bool Profiler::enabled()
+{
+    return _enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::setEnabled(bool value)
+{
+    _enabled = value;
+}
+
+void Profiler::setThreadName(const char* name)
+{
+    auto thread = _thread();
+    std::lock_guard<std::mutex> lock(thread->mutex);
+    thread->name = name;
+}
+
+void Profiler::beginFrame()
+{
+    if (!enabled()) return;
+    if (_frames.empty()) _frames.resize(FRAMES);
+    _frames[_frameCount++ % FRAMES] = now();
+}
+
+void Profiler::record(const char* name, uint64_t start, uint64_t duration)
+{
+    auto thread = _thread();
+    // Only dumps compete for the lock
+    std::lock_guard<std::mutex> lock(thread->mutex);
+    thread->samples[thread->count++ % SAMPLES_PER_THREAD] = {name, start, duration};
+}
+
+std::map<std::string, Profiler::Summary> Profiler::summary()
+{
+    std::map<std::string, Summary> result;
+    if (_frameCount < 2) return result;
+
+    // Only complete frames are counted, the current one is not
+    unsigned int frames = (unsigned int)std::min<uint64_t>(_frameCount - 1, FRAMES - 1);
+    std::vector<uint64_t> starts;
+    for (uint64_t i = _frameCount - frames - 1; i != _frameCount; ++i)
+    {
+        starts.push_back(_frames[i % FRAMES]);
+    }
+
+    std::map<std::string, std::vector<uint64_t>> times;
+    std::lock_guard<std::mutex> threadsLock(_threadsMutex);
+    for (auto& thread : _threads)
+    {
+        std::lock_guard<std::mutex> lock(thread->mutex);
+        auto count = std::min<uint64_t>(thread->count, SAMPLES_PER_THREAD);
+        for (uint64_t i = 0; i != count; ++i)
+        {
+            auto& sample = thread->samples[i];
+            if (sample.start < starts.front() || sample.start >= starts.back()) continue;
+
+            auto frame = std::upper_bound(starts.begin(), starts.end(), sample.start) - starts.begin() - 1;
+            auto& frameTimes = times[sample.name];
+            if (frameTimes.empty()) frameTimes.resize(frames);
+            frameTimes[frame] += sample.duration;
+        }
+    }
+
+    for (auto& it : times)
+    {
+        uint64_t total = 0;
+        auto& summary = result[it.first];
+        for (auto time : it.second)
+        {
+            total += time;
+            summary.maximum = std::max(summary.maximum, time);
+        }
+        summary.average = total / frames;
+    }
+    return result;
+}
+
+std::string Profiler::traceJson()
+{
+    std::stringstream stream;
+    stream << std::fixed << std::setprecision(3);
+    stream << "{\"traceEvents\": [";
+
+    bool first = true;
+    std::lock_guard<std::mutex> threadsLock(_threadsMutex);
+    for (auto& thread : _threads)
+    {
+        std::lock_guard<std::mutex> lock(thread->mutex);
+        if (!thread->name.empty())
+        {
+            stream << (first ? "" : ",") << "\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << thread->id
+                   << ", \"args\": {\"name\": \"" << thread->name << "\"}}";
+            first = false;
+        }
+
+        // Names are string literals, they need no escaping. Times are in microseconds
+        auto count = std::min<uint64_t>(thread->count, SAMPLES_PER_THREAD);
+        for (uint64_t i = 0; i != count; ++i)
+        {
+            auto& sample = thread->samples[i];
+            stream << (first ? "" : ",") << "\n{\"name\": \"" << sample.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << thread->id
+                   << ", \"ts\": " << sample.start / 1000.0 << ", \"dur\": " << sample.duration / 1000.0 << "}";
+            first = false;
+        }
+    }
+    stream << "\n], \"displayTimeUnit\": \"ms\"}";
+    return stream.str();
+}
+
+bool Profiler::saveTrace(const std::string& filename)
+{
+    std::ofstream stream(filename);
+    if (!stream.is_open()) return false;
+    stream << traceJson() << std::endl;
+    return true;
+}
+
+uint64_t Profiler::now()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+Profiler::Thread* Profiler::_thread()
+{
+    // Threads are never unregistered, samples of finished threads stay in traces
+    thread_local Thread* thread = nullptr;
+    if (!thread)
+    {
+        std::unique_ptr<Thread> newThread(new Thread());
+        newThread->samples.resize(SAMPLES_PER_THREAD);
+        thread = newThread.get();
+
+        std::lock_guard<std::mutex> lock(_threadsMutex);
+        newThread->id = _threads.size() + 1;
+        _threads.push_back(std::move(newThread));
+    }
+    return thread;
+}
+
+}
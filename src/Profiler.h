@@ -0,0 +1,134 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FALLTERGEIST_PROFILER_H
+#define FALLTERGEIST_PROFILER_H
+
+// C++ standard includes
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Falltergeist includes
+
+// Third party includes
+
+namespace Falltergeist
+{
+
+/**
+ * @brief Collects timings of code sections marked with FALLTERGEIST_PROFILE.
+ * Every thread writes into its own ring buffer, so the last few seconds of samples are always at hand.
+ * Nothing is recorded until the profiler is enabled.
+ */
+class Profiler
+{
+public:
+    struct Sample
+    {
+        const char* name;
+        uint64_t start;    // nanoseconds
+        uint64_t duration; // nanoseconds
+    };
+
+    // Time spent in a section per frame, over the last frames
+    struct Summary
+    {
+        uint64_t average = 0; // nanoseconds
+        uint64_t maximum = 0; // nanoseconds
+    };
+
+    /**
+     * Records time between its construction and destruction. Names must be string literals, only pointers are kept.
+     */
+    class Scope
+    {
+    public:
+        template <std::size_t N>
+        explicit Scope(const char (&name)[N]) : _name(name), _start(enabled() ? now() : 0)
+        {
+        }
+
+        ~Scope()
+        {
+            if (_start) Profiler::record(_name, _start, now() - _start);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    protected:
+        const char* _name;
+        uint64_t _start;
+    };
+
+    static const unsigned int SAMPLES_PER_THREAD;
+    static const unsigned int FRAMES;
+
+    static bool enabled();
+    static void setEnabled(bool value);
+
+    /**
+     * Names calling thread in traces.
+     */
+    static void setThreadName(const char* name);
+    /**
+     * Marks start of a new frame. Called from the main loop after every rendered frame.
+     */
+    static void beginFrame();
+    static void record(const char* name, uint64_t start, uint64_t duration);
+
+    /**
+     * Per section times over the last FRAMES frames, sections of all threads included.
+     */
+    static std::map<std::string, Summary> summary();
+    /**
+     * Samples of all threads in Chrome trace event format, to be opened in chrome://tracing.
+     */
+    static std::string traceJson();
+    static bool saveTrace(const std::string& filename);
+
+    // Monotonic time in nanoseconds
+    static uint64_t now();
+
+protected:
+    struct Thread;
+
+    static std::atomic<bool> _enabled;
+    static std::mutex _threadsMutex;
+    static std::vector<std::unique_ptr<Thread>> _threads;
+    // Start times of the last frames, used by main thread only
+    static std::vector<uint64_t> _frames;
+    static uint64_t _frameCount;
+
+    static Thread* _thread();
+};
+
+}
+
+#define FALLTERGEIST_PROFILE_CONCAT(a, b) a##b
+#define FALLTERGEIST_PROFILE_SCOPE(name, line) Falltergeist::Profiler::Scope FALLTERGEIST_PROFILE_CONCAT(profilerScope, line)(name)
+// Times the rest of enclosing block
+#define FALLTERGEIST_PROFILE(name) FALLTERGEIST_PROFILE_SCOPE(name, __LINE__)
+
+#endif // FALLTERGEIST_PROFILER_H
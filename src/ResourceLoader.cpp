@@ -0,0 +1,384 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// C++ standard includes
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <set>
+
+// Falltergeist includes
+#include "CrossPlatform.h"
+#include "Exception.h"
+#include "Logger.h"
+#include "Pack/File.h"
+#include "Pack/StreamBuffer.h"
+#include "Profiler.h"
+#include "ResourceLoader.h"
+#include "ResourceManager.h"
+#include "ResourceStatistics.h"
+
+// Third party includes
+#include <libfalltergeist/Dat/File.h>
+#include <libfalltergeist/Dat/Item.h>
+#include <libfalltergeist/Enums.h>
+#include <libfalltergeist/Exception.h>
+#include <libfalltergeist/Frm/File.h>
+#include <libfalltergeist/Lst/File.h>
+#include <libfalltergeist/Map/Elevation.h>
+#include <libfalltergeist/Map/File.h>
+#include <libfalltergeist/Pal/File.h>
+#include <libfalltergeist/Pro/File.h>
+
+namespace Falltergeist
+{
+
+using namespace libfalltergeist;
+
+namespace
+{
+// Map proto callback has no context argument
+thread_local ResourceLoader* currentLoader = nullptr;
+
+std::string lowercase(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+    return value;
+}
+}
+
+ResourceLoader::ResourceLoader(const std::string& packFilename) : _packFilename(packFilename)
+{
+}
+
+ResourceLoader::~ResourceLoader()
+{
+    stop();
+}
+
+void ResourceLoader::request(const std::string& name, bool texture)
+{
+    // Results are taken over by ResourceManager cache, which is keyed by lowercase names
+    auto filename = lowercase(name);
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_stopped || !_pending.insert(filename).second) return;
+
+    _queue.push_back({filename, texture, -1});
+    if (!_thread.joinable())
+    {
+        _thread = std::thread(&ResourceLoader::_run, this);
+    }
+    _condition.notify_one();
+}
+
+void ResourceLoader::requestMap(const std::string& name, unsigned int elevation)
+{
+    auto filename = lowercase(name);
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_stopped || !_pending.insert(filename).second) return;
+
+    _queue.push_back({filename, false, (int)elevation});
+    if (!_thread.joinable())
+    {
+        _thread = std::thread(&ResourceLoader::_run, this);
+    }
+    _condition.notify_one();
+}
+
+bool ResourceLoader::pending(const std::string& filename) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _pending.find(lowercase(filename)) != _pending.end();
+}
+
+unsigned int ResourceLoader::pendingCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _pending.size();
+}
+
+std::vector<ResourceLoader::Result> ResourceLoader::takeReady()
+{
+    std::vector<Result> ready;
+    std::lock_guard<std::mutex> lock(_mutex);
+    ready.swap(_ready);
+    return ready;
+}
+
+void ResourceLoader::cancel()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& request : _queue)
+    {
+        _pending.erase(request.filename);
+    }
+    _queue.clear();
+}
+
+void ResourceLoader::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopped = true;
+        _queue.clear();
+        _pending.clear();
+    }
+    _condition.notify_one();
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+}
+
+void ResourceLoader::_run()
+{
+    Profiler::setThreadName("resource loader");
+    while (true)
+    {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (_queue.empty() && !_stopped)
+            {
+                // DAT items keep inflated data, so handles are dropped once there is nothing to do
+                lock.unlock();
+                _closeSources();
+                lock.lock();
+            }
+            _condition.wait(lock, [this]() { return _stopped || !_queue.empty(); });
+            if (_stopped) break;
+            request = _queue.front();
+            _queue.pop_front();
+        }
+
+        FALLTERGEIST_PROFILE("ResourceLoader::load");
+        Result result;
+        result.filename = request.filename;
+        uint64_t startTime = ResourceStatistics::now();
+        try
+        {
+            _openSources();
+            result.item = _load(request.filename, result.bytesRead);
+            if (result.item)
+            {
+                if (request.elevation >= 0)
+                {
+                    _loadMapDependencies(result.item.get(), request.elevation);
+                }
+                // Plain map requests are parsed on first access with ResourceManager proto callback
+                else if (!dynamic_cast<Map::File*>(result.item.get()))
+                {
+                    _decode(result.item.get(), request.texture, result.bytesRead);
+                }
+                result.bytesInflated = result.item->size();
+            }
+        }
+        catch (const libfalltergeist::Exception& e)
+        {
+            Logger::error("RESOURCE LOADER") << request.filename << ": " << e.what() << std::endl;
+            result.item.reset();
+        }
+        catch (const Exception& e)
+        {
+            Logger::error("RESOURCE LOADER") << request.filename << ": " << e.what() << std::endl;
+            result.item.reset();
+        }
+        result.decodeTime = ResourceStatistics::now() - startTime;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        // stop() or cancel() may have happened meanwhile
+        if (_pending.erase(request.filename) && result.item)
+        {
+            // Map may point to its protos, they are handed over first
+            for (auto& dependency : _dependencies)
+            {
+                _ready.push_back(std::move(dependency));
+            }
+            _ready.push_back(std::move(result));
+        }
+        _dependencies.clear();
+        _dependencyMap.clear();
+    }
+    _closeSources();
+}
+
+void ResourceLoader::_openSources()
+{
+    if (!_datFiles.empty()) return;
+
+    if (!_packFilename.empty())
+    {
+        _pack.reset(new Pack::File(_packFilename));
+    }
+    for (auto& name : *CrossPlatform::findFalloutDataFiles())
+    {
+        _datFiles.push_back(std::unique_ptr<Dat::File>(new Dat::File(CrossPlatform::findFalloutDataPath() + "/" + name)));
+    }
+}
+
+void ResourceLoader::_closeSources()
+{
+    _palette.reset();
+    _datFiles.clear();
+    _pack.reset();
+}
+
+// Same search order as ResourceManager::datFileItem()
+bool ResourceLoader::_read(const std::string& filename, std::vector<char>& data, uint64_t& bytesRead)
+{
+    if (_pack)
+    {
+        if (auto entry = _pack->entry(filename))
+        {
+            data = _pack->data(entry);
+            bytesRead += entry->packedSize;
+            return true;
+        }
+    }
+
+    for (auto path : {CrossPlatform::findFalloutDataPath(), CrossPlatform::findFalltergeistDataPath()})
+    {
+        std::ifstream stream(path + "/" + filename, std::ios_base::binary);
+        if (stream.is_open())
+        {
+            data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+            bytesRead += data.size();
+            return true;
+        }
+    }
+
+    for (auto& datFile : _datFiles)
+    {
+        if (auto item = datFile->item(filename))
+        {
+            data.resize(item->size());
+            item->setPosition(0);
+            if (!data.empty()) item->readBytes(data.data(), data.size());
+            bytesRead += item->packedSize();
+            return true;
+        }
+    }
+    return false;
+}
+
+std::unique_ptr<Dat::Item> ResourceLoader::_load(const std::string& filename, uint64_t& bytesRead)
+{
+    std::vector<char> data;
+    if (!_read(filename, data, bytesRead)) return nullptr;
+
+    Pack::StreamBuffer buffer(std::move(data));
+    std::ifstream stream;
+    buffer.attach(stream);
+    std::unique_ptr<Dat::Item> item(ResourceManager::_createItemByName(filename, &stream));
+    item->setFilename(filename);
+    return item;
+}
+
+void ResourceLoader::_decode(Dat::Item* item, bool texture, uint64_t& bytesRead)
+{
+    item->setPosition(0);
+    auto frm = dynamic_cast<Frm::File*>(item);
+    if (texture && frm)
+    {
+        if (!_palette) _palette = _load("color.pal", bytesRead);
+        frm->rgba(dynamic_cast<Pal::File*>(_palette.get()));
+    }
+}
+
+void ResourceLoader::_loadMapDependencies(Dat::Item* item, unsigned int elevation)
+{
+    auto map = dynamic_cast<Map::File*>(item);
+    if (!map) return;
+
+    currentLoader = this;
+    map->setCallback(&ResourceLoader::_fetchProFileType);
+    auto elevations = map->elevations();
+    currentLoader = nullptr;
+
+    auto lst = dynamic_cast<Lst::File*>(_dependency("art/tiles/tiles.lst"));
+    if (!lst || elevation >= elevations->size()) return;
+
+    // Same tiles the location TileMap atlases are made of, with pixels already converted
+    std::set<unsigned int> tiles;
+    tiles.insert(elevations->at(elevation)->floorTiles()->begin(), elevations->at(elevation)->floorTiles()->end());
+    tiles.insert(elevations->at(elevation)->roofTiles()->begin(), elevations->at(elevation)->roofTiles()->end());
+    for (auto tileNum : tiles)
+    {
+        if (tileNum <= 1 || tileNum >= lst->strings()->size()) continue;
+        _dependency(lowercase("art/tiles/" + lst->strings()->at(tileNum)), true);
+    }
+}
+
+Dat::Item* ResourceLoader::_dependency(const std::string& filename, bool texture)
+{
+    auto it = _dependencyMap.find(filename);
+    if (it != _dependencyMap.end()) return it->second;
+
+    Result result;
+    result.filename = filename;
+    uint64_t startTime = ResourceStatistics::now();
+    try
+    {
+        result.item = _load(filename, result.bytesRead);
+        if (result.item)
+        {
+            _decode(result.item.get(), texture, result.bytesRead);
+            result.bytesInflated = result.item->size();
+        }
+    }
+    catch (const libfalltergeist::Exception& e)
+    {
+        Logger::error("RESOURCE LOADER") << filename << ": " << e.what() << std::endl;
+        result.item.reset();
+    }
+    result.decodeTime = ResourceStatistics::now() - startTime;
+
+    // Missing files are remembered as well, so they are not searched for again
+    auto item = result.item.get();
+    _dependencyMap.insert(std::make_pair(filename, item));
+    if (item)
+    {
+        _dependencies.push_back(std::move(result));
+    }
+    return item;
+}
+
+// Same lookup as ResourceManager::proFileType(unsigned int)
+Pro::File* ResourceLoader::_proFileType(unsigned int PID)
+{
+    static const std::map<OBJECT_TYPE, std::string> directories = {
+        {OBJECT_TYPE::ITEM, "items"}, {OBJECT_TYPE::CRITTER, "critters"}, {OBJECT_TYPE::SCENERY, "scenery"},
+        {OBJECT_TYPE::WALL, "walls"}, {OBJECT_TYPE::TILE, "tiles"}, {OBJECT_TYPE::MISC, "misc"}
+    };
+    auto directory = directories.find((OBJECT_TYPE)(PID >> 24));
+    if (directory == directories.end()) return nullptr;
+
+    auto lst = dynamic_cast<Lst::File*>(_dependency("proto/" + directory->second + "/" + directory->second + ".lst"));
+    unsigned int index = 0x00000FFF & PID;
+    if (!lst || index == 0 || index > lst->strings()->size()) return nullptr;
+    return dynamic_cast<Pro::File*>(_dependency(lowercase("proto/" + directory->second + "/" + lst->strings()->at(index - 1))));
+}
+
+// static
+Pro::File* ResourceLoader::_fetchProFileType(unsigned int PID)
+{
+    return currentLoader->_proFileType(PID);
+}
+
+}
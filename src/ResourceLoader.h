@@ -0,0 +1,136 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FALLTERGEIST_RESOURCELOADER_H
+#define FALLTERGEIST_RESOURCELOADER_H
+
+// C++ standard includes
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Falltergeist includes
+
+// Third party includes
+
+namespace libfalltergeist
+{
+namespace Dat
+{
+class File;
+class Item;
+}
+namespace Pro { class File; }
+}
+
+namespace Falltergeist
+{
+namespace Pack
+{
+    class File;
+}
+
+/**
+ * @brief Loads and parses files on a background thread.
+ * The worker has its own DAT and pack handles, so it never touches ResourceManager state.
+ * Loaded items are handed over to ResourceManager on the main thread with takeReady().
+ */
+class ResourceLoader
+{
+public:
+    struct Result
+    {
+        std::string filename;
+        std::unique_ptr<libfalltergeist::Dat::Item> item;
+        uint64_t bytesRead = 0;
+        uint64_t bytesInflated = 0;
+        uint64_t decodeTime = 0;
+    };
+
+    ResourceLoader(const std::string& packFilename = "");
+    ~ResourceLoader();
+
+    /**
+     * Queues file for loading. With texture set, FRM pixels are converted on the worker as well.
+     */
+    void request(const std::string& filename, bool texture = false);
+    /**
+     * Queues map for loading. The map is parsed on the worker, its protos and LST files
+     * and floor and roof tiles of given elevation are handed over together with it.
+     */
+    void requestMap(const std::string& filename, unsigned int elevation);
+    /**
+     * Whether file is queued or being loaded right now.
+     */
+    bool pending(const std::string& filename) const;
+    unsigned int pendingCount() const;
+    std::vector<Result> takeReady();
+    /**
+     * Drops queued requests that are not started yet.
+     */
+    void cancel();
+    void stop();
+
+protected:
+    struct Request
+    {
+        std::string filename;
+        bool texture;
+        int elevation; // maps only, -1 for other files
+    };
+
+    std::string _packFilename;
+    std::thread _thread;
+    mutable std::mutex _mutex;
+    std::condition_variable _condition;
+    std::deque<Request> _queue;
+    std::unordered_set<std::string> _pending;
+    std::vector<Result> _ready;
+    bool _stopped = false;
+
+    // Used by worker thread only
+    std::unique_ptr<Pack::File> _pack;
+    std::vector<std::unique_ptr<libfalltergeist::Dat::File>> _datFiles;
+    std::unique_ptr<libfalltergeist::Dat::Item> _palette;
+    // Files loaded while parsing a map
+    std::vector<Result> _dependencies;
+    std::unordered_map<std::string, libfalltergeist::Dat::Item*> _dependencyMap;
+
+    void _run();
+    void _openSources();
+    void _closeSources();
+    bool _read(const std::string& filename, std::vector<char>& data, uint64_t& bytesRead);
+    std::unique_ptr<libfalltergeist::Dat::Item> _load(const std::string& filename, uint64_t& bytesRead);
+    void _decode(libfalltergeist::Dat::Item* item, bool texture, uint64_t& bytesRead);
+    void _loadMapDependencies(libfalltergeist::Dat::Item* item, unsigned int elevation);
+    libfalltergeist::Dat::Item* _dependency(const std::string& filename, bool texture = false);
+    libfalltergeist::Pro::File* _proFileType(unsigned int PID);
+    static libfalltergeist::Pro::File* _fetchProFileType(unsigned int PID);
+};
+
+}
+
+#endif // FALLTERGEIST_RESOURCELOADER_H
@@ -28,11 +28,18 @@
 #include "CrossPlatform.h"
 #include "Exception.h"
 #include "Font.h"
+#include "Game/Game.h"
 #include "Game/Location.h"
+#include "Graphics/Renderer.h"
 #include "Graphics/Texture.h"
+#include "Graphics/TextureAtlas.h"
 #include "Logger.h"
 #include "ResourceManager.h"
 #include "Ini/File.h"
+#include "Pack/File.h"
+#include "Pack/StreamBuffer.h"
+#include "Profiler.h"
+#include "ResourceLoader.h"
 
 // Third party includes
 #include <libfalltergeist/Acm/File.h>
@@ -65,6 +72,11 @@ using Base::make_unique;
 
 namespace
 {
+// Time spent on creating prewarmed textures and fonts per frame, microseconds
+const uint64_t PREWARM_FRAME_TIME = 4000;
+// Session profile is cut after this many entries
+const unsigned int PROFILE_MAX_SIZE = 8192;
+
 Pro::File* fetchProFileType(unsigned int PID)
 {
     return ResourceManager::getInstance()->proFileType(PID);
@@ -79,10 +91,25 @@ ResourceManager::ResourceManager()
         string path = CrossPlatform::findFalloutDataPath() + "/" + (*it);
         _datFiles.push_back(make_unique<Dat::File>(path));
     }
+
+    // Pack built by falltergeist-packer is preferred over DAT files and data directories
+    for (auto path : {CrossPlatform::findFalltergeistDataPath(), CrossPlatform::findFalloutDataPath()})
+    {
+        ifstream stream(path + "/falltergeist.pak", ios_base::binary);
+        if (!stream.is_open()) continue;
+        stream.close();
+
+        _pack = make_unique<Pack::File>(path + "/falltergeist.pak");
+        Logger::info("RESOURCE MANAGER") << "Mounted pack: " << _pack->filename() << " [" << _pack->size() << " entries]" << endl;
+        break;
+    }
+
+    _loader = make_unique<ResourceLoader>(_pack ? _pack->filename() : "");
 }
 
 ResourceManager::~ResourceManager()
 {
+    _loader->stop();
 }
 
 // static
@@ -95,13 +122,44 @@ Dat::Item* ResourceManager::datFileItem(string filename)
 {
     std::transform(filename.begin(), filename.end(), filename.begin(), ::tolower);
 
+    string type = ResourceStatistics::type(filename);
+    _recordProfile("i " + filename);
+
     // Return item from cache
     auto itemIt = _datItemMap.find(filename);
+    if (itemIt == _datItemMap.end())
+    {
+        // Item may be already loaded in background
+        _takeLoadedItems();
+        itemIt = _datItemMap.find(filename);
+    }
     if (itemIt != _datItemMap.end())
     {
+        _statistics.hit(type);
         return itemIt->second;
     }
 
+    FALLTERGEIST_PROFILE("ResourceManager::load");
+    uint64_t startTime = ResourceStatistics::now();
+
+    // Searching file in mounted pack
+    if (_pack)
+    {
+        if (auto entry = _pack->entry(filename))
+        {
+            Logger::debug("RESOURCE MANAGER") << "Loading file: " << filename << " [FROM " << _pack->filename() << "]" << endl;
+            Pack::StreamBuffer buffer(_pack->data(entry));
+            ifstream stream;
+            buffer.attach(stream);
+            Dat::Item* item = _createItemByName(filename, &stream);
+            item->setFilename(filename);
+            _datItems.push_back(unique_ptr<Dat::Item>(item));
+            _datItemMap.insert(make_pair(filename, item));
+            _statistics.miss(type, entry->packedSize, entry->size, ResourceStatistics::now() - startTime, entry->size);
+            return item;
+        }
+    }
+
     // Searching file in Fallout data directory
     {
         string path = CrossPlatform::findFalloutDataPath() + "/" + filename;
@@ -127,6 +185,7 @@ Dat::Item* ResourceManager::datFileItem(string filename)
             item->setFilename(filename);
             _datItems.push_back(unique_ptr<Dat::Item>(item));
             _datItemMap.insert(make_pair(filename, item));
+            _statistics.miss(type, item->size(), item->size(), ResourceStatistics::now() - startTime, item->size());
             return item;
         }
     }
@@ -138,7 +197,10 @@ Dat::Item* ResourceManager::datFileItem(string filename)
         if (item)
         {
             Logger::debug("RESOURCE MANAGER") << "Loading file: " << filename << " [FROM " << datfile->filename() << "]" << endl;
+            // DAT items are inflated and parsed on first access, force it here to account decode time
+            item->setPosition(0);
             _datItemMap.insert(make_pair(filename, item));
+            _statistics.miss(type, item->packedSize(), item->unpackedSize(), ResourceStatistics::now() - startTime, item->unpackedSize());
             return item;
         }
     }
@@ -146,6 +208,11 @@ Dat::Item* ResourceManager::datFileItem(string filename)
     return 0;
 }
 
+Dat::Item* ResourceManager::createItem(const string& filename, ifstream* stream)
+{
+    return _createItemByName(filename, stream);
+}
+
 Dat::Item* ResourceManager::_createItemByName(const string& filename, ifstream* stream)
 {
     string extension = filename.substr(filename.length() - 3, 3);
@@ -311,16 +378,27 @@ Txt::QuestsFile* ResourceManager::questsTxt()
 
 Graphics::Texture* ResourceManager::texture(const string& filename)
 {
+    _recordProfile("t " + filename);
+
     if (_textures.find(filename) != _textures.end())
     {
+        _statistics.hit("texture");
         return _textures.at(filename).get();
     }
 
+    FALLTERGEIST_PROFILE("ResourceManager::texture");
+    uint64_t startTime = ResourceStatistics::now();
+
     string ext = filename.substr(filename.length() - 4);
 
-    Graphics::Texture* texture = nullptr;
+    uint64_t bytesRead = 0;
+    Graphics::Texture* texture = _packedTexture(filename, bytesRead);
 
-    if (ext == ".png")
+    if (texture)
+    {
+        // pre-converted by falltergeist-packer
+    }
+    else if (ext == ".png")
     {
         // @fixme: this section looks quite ugly. we should try to do something with it someday
         SDL_Surface* tempSurface = IMG_Load(string(CrossPlatform::findFalltergeistDataPath() + "/" +filename).c_str());
@@ -349,8 +427,20 @@ Graphics::Texture* ResourceManager::texture(const string& filename)
     {
         auto frm = frmFileType(filename);
         if (!frm) return nullptr;
-        texture = new Graphics::Texture(frm->width(), frm->height());
+        texture = _createTexture(filename, frm->width(), frm->height());
         texture->loadFromRGBA(frm->rgba(palFileType("color.pal")));
+        // FRM may be unloaded meanwhile, it is looked up again
+        texture->setPixelSource([this, filename](Graphics::Texture* texture)
+        {
+            auto frm = frmFileType(filename);
+            if (!frm)
+            {
+                // Surface stays transparent
+                Logger::error("RESOURCE MANAGER") << "Can't restore pixels of texture: " << filename << endl;
+                return;
+            }
+            texture->loadFromRGBA(frm->rgba(palFileType("color.pal")));
+        });
     }
     else
     {
@@ -358,21 +448,103 @@ Graphics::Texture* ResourceManager::texture(const string& filename)
     }
 
     _textures.insert(make_pair(filename, unique_ptr<Graphics::Texture>(texture)));
+    uint64_t size = texture->width() * texture->height() * 4;
+    _statistics.miss("texture", bytesRead, size, ResourceStatistics::now() - startTime, size);
+    return texture;
+}
+
+Graphics::Texture* ResourceManager::_packedTexture(const string& filename, uint64_t& bytesRead)
+{
+    if (!_pack) return nullptr;
+
+    string name = filename;
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    auto entry = _pack->entry(name + Pack::TEXTURE_SUFFIX);
+    if (!entry || entry->kind != Pack::KIND::TEXTURE) return nullptr;
+
+    std::vector<char> data;
+    unsigned int width, height;
+    _readPackedPixels(entry, filename, data, width, height);
+    bytesRead = entry->packedSize;
+
+    Logger::debug("RESOURCE MANAGER") << "Loading texture: " << filename << " [FROM " << _pack->filename() << "]" << endl;
+    auto texture = _createTexture(name, width, height);
+    texture->loadFromRGBA((unsigned int*)(data.data() + 8));
+    texture->setPixelSource([this, entry, filename](Graphics::Texture* texture)
+    {
+        std::vector<char> data;
+        unsigned int width, height;
+        _readPackedPixels(entry, filename, data, width, height);
+        texture->loadFromRGBA((unsigned int*)(data.data() + 8));
+    });
     return texture;
 }
 
+bool ResourceManager::packedPixels(const string& filename, std::vector<char>& data, unsigned int& width, unsigned int& height)
+{
+    if (!_pack) return false;
+
+    string name = filename;
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    auto entry = _pack->entry(name + Pack::TEXTURE_SUFFIX);
+    if (!entry || entry->kind != Pack::KIND::TEXTURE) return false;
+
+    _readPackedPixels(entry, filename, data, width, height);
+    return true;
+}
+
+void ResourceManager::_readPackedPixels(const Pack::Entry* entry, const string& filename, std::vector<char>& data, unsigned int& width, unsigned int& height)
+{
+    data = _pack->data(entry);
+    if (data.size() < 8)
+    {
+        throw Exception("ResourceManager::_readPackedPixels() - wrong texture size: " + filename);
+    }
+    width = Pack::readUInt32((const unsigned char*)data.data());
+    height = Pack::readUInt32((const unsigned char*)data.data() + 4);
+    if (data.size() != 8 + width * height * 4)
+    {
+        throw Exception("ResourceManager::_readPackedPixels() - wrong texture size: " + filename);
+    }
+}
+
+Graphics::Texture* ResourceManager::_createTexture(const string& filename, unsigned int width, unsigned int height)
+{
+    // Sprites go to shared atlas. Tiles are only copied into TileMap textures and never drawn on their own
+    auto atlas = Game::getInstance()->renderer()->atlas();
+    string ext = filename.substr(filename.length() - 4);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    if (ext == ".frm" && filename.compare(0, 10, "art/tiles/") != 0 && atlas && atlas->accepts(width, height))
+    {
+        return new Graphics::Texture(width, height, atlas);
+    }
+    return new Graphics::Texture(width, height);
+}
+
 Font* ResourceManager::font(const string& filename, unsigned int color)
 {
     string fontname = filename + std::to_string(color);
+    _recordProfile("f " + filename + " " + std::to_string(color));
 
     if (_fonts.find(fontname) != _fonts.end())
     {
+        _statistics.hit("font");
         return _fonts.at(fontname).get();
     }
 
-    auto font = make_unique<Font>(filename, color);
+    FALLTERGEIST_PROFILE("ResourceManager::font");
+    uint64_t startTime = ResourceStatistics::now();
+    uint64_t size = 0;
+    auto& texture = _fontTextures[filename];
+    if (!texture)
+    {
+        texture = Font::createTexture(aafFileType(filename));
+        size = texture->width() * texture->height() * 4;
+    }
+    auto font = make_unique<Font>(filename, color, texture.get());
     Font* fontPtr = font.get();
     _fonts.insert(make_pair(fontname, std::move(font)));
+    _statistics.miss("font", 0, size, ResourceStatistics::now() - startTime, size);
     return fontPtr;
 }
 
@@ -439,6 +611,12 @@ void ResourceManager::unloadResources()
 {
     _datItems.clear();
     _datItemMap.clear();
+
+    for (auto& counters : _statistics.counters())
+    {
+        if (counters.first == "texture" || counters.first == "font") continue;
+        _statistics.release(counters.first);
+    }
 }
 
 Frm::File* ResourceManager::frmFileType(unsigned int FID)
@@ -612,7 +790,6 @@ Game::Location* ResourceManager::gameLocation(unsigned int number)
     for (auto property : *section.get())
     {
         string name = property.first;
-        Logger::critical() << name << endl;
         if (name == "lookup_name")
         {
             location->setName(property.second.value());
@@ -638,9 +815,167 @@ Game::Location* ResourceManager::gameLocation(unsigned int number)
     return location;
 }
 
+ResourceStatistics* ResourceManager::statistics()
+{
+    return &_statistics;
+}
+
+ResourceLoader* ResourceManager::loader()
+{
+    return _loader.get();
+}
+
+void ResourceManager::_takeLoadedItems()
+{
+    for (auto& result : _loader->takeReady())
+    {
+        // Loaded on main thread meanwhile. The copy is kept anyway, prefetched maps may point to it
+        if (_datItemMap.find(result.filename) != _datItemMap.end())
+        {
+            _datItems.push_back(std::move(result.item));
+            continue;
+        }
+
+        Logger::debug("RESOURCE MANAGER") << "Loading file: " << result.filename << " [FROM BACKGROUND LOADER]" << endl;
+        Dat::Item* item = result.item.release();
+        _datItems.push_back(unique_ptr<Dat::Item>(item));
+        _datItemMap.insert(make_pair(result.filename, item));
+        _statistics.miss(ResourceStatistics::type(result.filename), result.bytesRead, result.bytesInflated, result.decodeTime, result.bytesInflated);
+    }
+}
+
+void ResourceManager::_recordProfile(const string& entry)
+{
+    if (!_recordingProfile || _prewarming || _profile.size() >= PROFILE_MAX_SIZE) return;
+    if (_profileEntries.insert(entry).second)
+    {
+        _profile.push_back(entry);
+    }
+}
+
+void ResourceManager::prewarm()
+{
+    string filename = CrossPlatform::getConfigPath() + "/session.profile";
+    ifstream stream(filename);
+    if (!stream.is_open()) return;
+
+    // i <file> - any file, t <file> - texture, f <file> <color> - font
+    string line;
+    unsigned int entries = 0;
+    while (getline(stream, line))
+    {
+        if (line.length() < 3 || line[1] != ' ') continue;
+
+        string name = line.substr(2, line.find(' ', 2) - 2);
+        switch (line[0])
+        {
+            case 'i':
+                _loader->request(name);
+                break;
+            case 't':
+                _loader->request(name, true);
+                _prewarmQueue.push_back(line);
+                break;
+            case 'f':
+                _loader->request(name);
+                _prewarmQueue.push_back(line);
+                break;
+            default:
+                continue;
+        }
+        entries++;
+    }
+    Logger::info("RESOURCE MANAGER") << "Prewarming " << entries << " resources from " << filename << endl;
+}
+
+void ResourceManager::saveProfile()
+{
+    if (!_recordingProfile) return;
+    _recordingProfile = false;
+
+    CrossPlatform::createDirectory(CrossPlatform::getConfigPath());
+    string filename = CrossPlatform::getConfigPath() + "/session.profile";
+    ofstream stream(filename);
+    if (!stream.is_open())
+    {
+        Logger::warning("RESOURCE MANAGER") << "Cannot save session profile to " << filename << endl;
+        return;
+    }
+    for (auto& entry : _profile)
+    {
+        stream << entry << endl;
+    }
+    Logger::info("RESOURCE MANAGER") << "Session profile saved to " << filename << " [" << _profile.size() << " entries]" << endl;
+
+    _profile.clear();
+    _profileEntries.clear();
+}
+
+void ResourceManager::update()
+{
+    FALLTERGEIST_PROFILE("ResourceManager::update");
+    _takeLoadedItems();
+
+    // Textures and fonts can be created on the main thread only, a few of them per frame in recorded order
+    uint64_t startTime = ResourceStatistics::now();
+    _prewarming = true;
+    while (!_prewarmQueue.empty() && ResourceStatistics::now() - startTime < PREWARM_FRAME_TIME)
+    {
+        const string& line = _prewarmQueue.front();
+        auto separator = line.find(' ', 2);
+        string name = line.substr(2, separator - 2);
+        if (_loader->pending(name)) break;
+
+        if (line[0] == 't')
+        {
+            texture(name);
+        }
+        else if (separator != string::npos)
+        {
+            font(name, std::stoul(line.substr(separator + 1)));
+        }
+        _prewarmQueue.pop_front();
+    }
+    _prewarming = false;
+}
+
+bool ResourceManager::updatePending() const
+{
+    return !_prewarmQueue.empty();
+}
+
 void ResourceManager::shutdown()
 {
+    _loader->stop();
+    _prewarmQueue.clear();
+    string filename = CrossPlatform::getConfigPath() + "/resources.json";
+    if (_statistics.saveJson(filename))
+    {
+        Logger::info("RESOURCE MANAGER") << "Resource statistics saved to " << filename << endl;
+    }
     unloadResources();
+    _unloadTextures();
+}
+
+void ResourceManager::_unloadTextures()
+{
+    // Font textures are shared, their size was accounted with the first font made of each of them
+    uint64_t fontTextureSize = 0;
+    for (auto& it : _fontTextures)
+    {
+        if (it.second) fontTextureSize += it.second->width() * it.second->height() * 4;
+    }
+    for (unsigned int i = 0; i != _fonts.size(); ++i)
+    {
+        _statistics.release("font", i == 0 ? fontTextureSize : 0);
+    }
+    for (auto& it : _textures)
+    {
+        _statistics.release("texture", it.second->width() * it.second->height() * 4);
+    }
+    _fonts.clear();
+    _fontTextures.clear();
+    _textures.clear();
 }
 
 }
@@ -21,14 +21,17 @@
 #define FALLTERGEIST_RESOURCEMANAGER_H
 
 // C++ standard includes
+#include <deque>
 #include <string>
 #include <map>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 // Falltergeist includes
 #include "Base/Singleton.h"
+#include "ResourceStatistics.h"
 
 // Third party includes
 #include <libfalltergeist/Lst/File.h>
@@ -95,8 +98,14 @@ namespace Graphics
 {
     class Texture;
 }
+namespace Pack
+{
+    struct Entry;
+    class File;
+}
 
 class Font;
+class ResourceLoader;
 
 class ResourceManager
 {
@@ -140,23 +149,71 @@ public:
     void unloadResources();
     std::string FIDtoFrmName(unsigned int FID);
     Game::Location* gameLocation(unsigned int number);
+    ResourceStatistics* statistics();
+    ResourceLoader* loader();
     void shutdown();
 
+    /**
+     * Parses file contents into libfalltergeist item of the type matching filename.
+     */
+    static libfalltergeist::Dat::Item* createItem(const std::string& filename, std::ifstream* stream);
+    /**
+     * Reads pixels pre-converted by falltergeist-packer: uint32 width, uint32 height and RGBA pixels.
+     * Returns false when there is no pack or it has no texture of the file.
+     */
+    bool packedPixels(const std::string& filename, std::vector<char>& data, unsigned int& width, unsigned int& height);
+
+    /**
+     * Starts loading resources recorded in session profile in background.
+     */
+    void prewarm();
+    /**
+     * Stops recording session profile and saves it for the next launch.
+     */
+    void saveProfile();
+    /**
+     * Takes over files loaded in background and creates prewarmed textures and fonts. Called once per frame.
+     */
+    void update();
+    /**
+     * Whether update() has prewarmed resources left to take over.
+     */
+    bool updatePending() const;
+
 protected:
     friend class Base::Singleton<ResourceManager>;
+    friend class ResourceLoader;
 
     std::vector<std::unique_ptr<libfalltergeist::Dat::File>> _datFiles;
     std::vector<std::unique_ptr<libfalltergeist::Dat::Item>> _datItems;
     std::unordered_map<std::string, libfalltergeist::Dat::Item*> _datItemMap;
     std::unordered_map<std::string, std::unique_ptr<Graphics::Texture>> _textures;
     std::unordered_map<std::string, std::unique_ptr<Font>> _fonts;
+    // Glyph atlases by font filename, shared by all colors
+    std::unordered_map<std::string, std::unique_ptr<Graphics::Texture>> _fontTextures;
+    std::unique_ptr<Pack::File> _pack;
+    ResourceStatistics _statistics;
+    std::unique_ptr<ResourceLoader> _loader;
+
+    bool _recordingProfile = true;
+    bool _prewarming = false;
+    std::vector<std::string> _profile;
+    std::unordered_set<std::string> _profileEntries;
+    std::deque<std::string> _prewarmQueue;
 
     ResourceManager();
     ~ResourceManager();
     ResourceManager(const ResourceManager&) = delete;
     ResourceManager& operator=(const ResourceManager&) = delete;
 
-    libfalltergeist::Dat::Item* _createItemByName(const std::string& filename, std::ifstream* stream);
+    static libfalltergeist::Dat::Item* _createItemByName(const std::string& filename, std::ifstream* stream);
+    void _takeLoadedItems();
+    void _recordProfile(const std::string& entry);
+    Graphics::Texture* _packedTexture(const std::string& filename, uint64_t& bytesRead);
+    // Frees textures and fonts, while renderer is still there
+    void _unloadTextures();
+    void _readPackedPixels(const Pack::Entry* entry, const std::string& filename, std::vector<char>& data, unsigned int& width, unsigned int& height);
+    Graphics::Texture* _createTexture(const std::string& filename, unsigned int width, unsigned int height);
 };
 
 }
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// C++ standard includes
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+// Falltergeist includes
+#include "ResourceStatistics.h"
+
+// Third party includes
+
+namespace Falltergeist
+{
+
+namespace
+{
+void writeCounters(std::ostream& stream, const ResourceStatistics::Counters& counters)
+{
+    stream << "{\"hits\": " << counters.hits
+           << ", \"misses\": " << counters.misses
+           << ", \"bytes_read\": " << counters.bytesRead
+           << ", \"bytes_inflated\": " << counters.bytesInflated
+           << ", \"decode_time_us\": " << counters.decodeTime
+           << ", \"resident_count\": " << counters.residentCount
+           << ", \"resident_size\": " << counters.residentSize << "}";
+}
+}
+
+ResourceStatistics::Counters& ResourceStatistics::Counters::operator+=(const Counters& other)
+{
+    hits          += other.hits;
+    misses        += other.misses;
+    bytesRead     += other.bytesRead;
+    bytesInflated += other.bytesInflated;
+    decodeTime    += other.decodeTime;
+    residentCount += other.residentCount;
+    residentSize  += other.residentSize;
+    return *this;
+}
+
+ResourceStatistics::Counters ResourceStatistics::Counters::operator-(const Counters& other) const
+{
+    Counters result;
+    result.hits          = hits - other.hits;
+    result.misses        = misses - other.misses;
+    result.bytesRead     = bytesRead - other.bytesRead;
+    result.bytesInflated = bytesInflated - other.bytesInflated;
+    result.decodeTime    = decodeTime - other.decodeTime;
+    // resident values are not cumulative
+    result.residentCount = residentCount;
+    result.residentSize  = residentSize;
+    return result;
+}
+
+ResourceStatistics::ResourceStatistics()
+{
+}
+
+ResourceStatistics::~ResourceStatistics()
+{
+}
+
+void ResourceStatistics::hit(const std::string& type)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _counters[type].hits++;
+}
+
+void ResourceStatistics::miss(const std::string& type, uint64_t bytesRead, uint64_t bytesInflated, uint64_t decodeTime, uint64_t residentSize)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& counters = _counters[type];
+    counters.misses++;
+    counters.bytesRead += bytesRead;
+    counters.bytesInflated += bytesInflated;
+    counters.decodeTime += decodeTime;
+    counters.residentCount++;
+    counters.residentSize += residentSize;
+}
+
+void ResourceStatistics::release(const std::string& type)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _counters.find(type);
+    if (it == _counters.end()) return;
+    it->second.residentCount = 0;
+    it->second.residentSize = 0;
+}
+
+void ResourceStatistics::release(const std::string& type, uint64_t residentSize)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _counters.find(type);
+    if (it == _counters.end() || it->second.residentCount == 0) return;
+    it->second.residentCount--;
+    it->second.residentSize -= std::min(residentSize, it->second.residentSize);
+}
+
+std::map<std::string, ResourceStatistics::Counters> ResourceStatistics::counters() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _counters;
+}
+
+ResourceStatistics::Counters ResourceStatistics::total() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Counters result;
+    for (auto& counters : _counters)
+    {
+        result += counters.second;
+    }
+    return result;
+}
+
+std::string ResourceStatistics::json() const
+{
+    auto types = counters();
+    Counters sum;
+
+    std::stringstream stream;
+    stream << "{\"types\": {";
+    for (auto it = types.begin(); it != types.end(); ++it)
+    {
+        if (it != types.begin()) stream << ", ";
+        stream << "\"" << it->first << "\": ";
+        writeCounters(stream, it->second);
+        sum += it->second;
+    }
+    stream << "}, \"total\": ";
+    writeCounters(stream, sum);
+    stream << "}";
+    return stream.str();
+}
+
+bool ResourceStatistics::saveJson(const std::string& filename) const
+{
+    std::ofstream stream(filename);
+    if (!stream.is_open()) return false;
+    stream << json() << std::endl;
+    return true;
+}
+
+std::map<std::string, ResourceStatistics::Counters> ResourceStatistics::difference(const std::map<std::string, Counters>& before,
+                                                                                   const std::map<std::string, Counters>& after)
+{
+    std::map<std::string, Counters> result;
+    for (auto& counters : after)
+    {
+        auto it = before.find(counters.first);
+        result[counters.first] = (it == before.end()) ? counters.second : counters.second - it->second;
+    }
+    return result;
+}
+
+std::string ResourceStatistics::type(const std::string& filename)
+{
+    auto position = filename.rfind('.');
+    if (position == std::string::npos) return "other";
+
+    std::string extension = filename.substr(position + 1);
+    // critter animations: frm0..frm6 and the misspelled fr3
+    if (extension.compare(0, 2, "fr") == 0) return "frm";
+    return extension;
+}
+
+uint64_t ResourceStatistics::now()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+}
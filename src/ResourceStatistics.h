@@ -0,0 +1,86 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FALLTERGEIST_RESOURCESTATISTICS_H
+#define FALLTERGEIST_RESOURCESTATISTICS_H
+
+// C++ standard includes
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Falltergeist includes
+
+// Third party includes
+
+namespace Falltergeist
+{
+
+/**
+ * @brief Per resource type counters collected by ResourceManager.
+ * Types are file extensions ("frm", "pro", "map"...) plus "texture" and "font" caches.
+ */
+class ResourceStatistics
+{
+public:
+    struct Counters
+    {
+        unsigned int hits = 0;
+        unsigned int misses = 0;
+        uint64_t bytesRead = 0;     // bytes read from disk, DAT or pack
+        uint64_t bytesInflated = 0; // bytes after decompression
+        uint64_t decodeTime = 0;    // microseconds
+        unsigned int residentCount = 0;
+        uint64_t residentSize = 0;
+
+        Counters& operator+=(const Counters& other);
+        Counters operator-(const Counters& other) const;
+    };
+
+    ResourceStatistics();
+    ~ResourceStatistics();
+
+    void hit(const std::string& type);
+    void miss(const std::string& type, uint64_t bytesRead, uint64_t bytesInflated, uint64_t decodeTime, uint64_t residentSize);
+    // All resources of the type are released
+    void release(const std::string& type);
+    // One resource of the type is released
+    void release(const std::string& type, uint64_t residentSize);
+
+    std::map<std::string, Counters> counters() const;
+    Counters total() const;
+
+    std::string json() const;
+    bool saveJson(const std::string& filename) const;
+
+    static std::map<std::string, Counters> difference(const std::map<std::string, Counters>& before,
+                                                      const std::map<std::string, Counters>& after);
+    static std::string type(const std::string& filename);
+    // Monotonic time in microseconds
+    static uint64_t now();
+
+protected:
+    mutable std::mutex _mutex;
+    std::map<std::string, Counters> _counters;
+};
+
+}
+
+#endif // FALLTERGEIST_RESOURCESTATISTICS_H
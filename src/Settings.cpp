@@ -67,6 +67,8 @@ bool Settings::save()
            << "height = " << _screenHeight << std::endl
            << "scale = "  << _scale << std::endl
            << "fullscreen = " << (_fullscreen ? "true" : "false") << std::endl
+           << "vsync = " << (_vsync ? "true" : "false") << std::endl
+           << "frame_cap = " << _frameCap << std::endl
            << "-- audio"  << std::endl
            << "audio_enabled = " << (_audioEnabled ? "true" : "false") << std::endl
            << "master_volume = " << std::to_string(_masterVolume) << std::endl
@@ -82,8 +84,11 @@ bool Settings::save()
            << "init_location = \"" << _initLocation << "\"" << std::endl
            << "force_location = " << (_forceLocation ? "true" : "false") << std::endl
            << "display_fps = " << (_displayFps ? "true" : "false") << std::endl
+           << "display_resource_statistics = " << (_displayResourceStatistics ? "true" : "false") << std::endl
+           << "display_profiler = " << (_displayProfiler ? "true" : "false") << std::endl
            << "worldmap_fullscreen = " << (_worldMapFullscreen ? "true" : "false") << std::endl
            << "display_mouse_position = " << (_displayMousePosition ? "true" : "false") << std::endl
+           << "pick_buffer = " << (_pickBuffer ? "true" : "false") << std::endl
            << "-- preferences" << std::endl
            << "brightness = "  << std::to_string(_brightness) << std::endl
            << "game_difficulty = " << _gameDifficulty << std::endl
@@ -151,6 +156,8 @@ bool Settings::load()
     _scale        = script.get("scale",  (int)_scale);
     if (_scale > 2) _scale = 2;
     _fullscreen   = script.get("fullscreen", (bool)_fullscreen);
+    _vsync        = script.get("vsync",      (bool)_vsync);
+    _frameCap     = script.get("frame_cap",  (int)_frameCap);
 
     _audioEnabled    = script.get("audio_enabled", (bool)_audioEnabled);
     _masterVolume    = script.get("master_volume", (double)_masterVolume);
@@ -169,8 +176,11 @@ bool Settings::load()
     _forceLocation = script.get("force_location", (bool)_forceLocation);
 
     _displayFps           = script.get("display_fps",            (bool)_displayFps);
+    _displayResourceStatistics = script.get("display_resource_statistics", (bool)_displayResourceStatistics);
+    _displayProfiler      = script.get("display_profiler",       (bool)_displayProfiler);
     _worldMapFullscreen   = script.get("worldmap_fullscreen",    (bool)_worldMapFullscreen);
     _displayMousePosition = script.get("display_mouse_position", (bool)_displayMousePosition);
+    _pickBuffer           = script.get("pick_buffer",            (bool)_pickBuffer);
 
     _brightness       = script.get("brightness",        (double)_brightness);
     _gameDifficulty   = script.get("game_difficulty",   (int)_gameDifficulty);
@@ -197,6 +207,16 @@ bool Settings::displayFps() const
     return _displayFps;
 }
 
+bool Settings::displayResourceStatistics() const
+{
+    return _displayResourceStatistics;
+}
+
+bool Settings::displayProfiler() const
+{
+    return _displayProfiler;
+}
+
 bool Settings::worldMapFullscreen() const
 {
     return _worldMapFullscreen;
@@ -207,6 +227,11 @@ bool Settings::displayMousePosition() const
     return _displayMousePosition;
 }
 
+bool Settings::pickBuffer() const
+{
+    return _pickBuffer;
+}
+
 void Settings::setVoiceVolume(double _voiceVolume)
 {
     this->_voiceVolume = _voiceVolume;
@@ -432,6 +457,26 @@ bool Settings::fullscreen() const
     return _fullscreen;
 }
 
+void Settings::setVsync(bool _vsync)
+{
+    this->_vsync = _vsync;
+}
+
+bool Settings::vsync() const
+{
+    return _vsync;
+}
+
+void Settings::setFrameCap(unsigned int _frameCap)
+{
+    this->_frameCap = _frameCap;
+}
+
+unsigned int Settings::frameCap() const
+{
+    return _frameCap;
+}
+
 void Settings::setAudioBufferSize(int _audioBufferSize)
 {
     this->_audioBufferSize = _audioBufferSize;
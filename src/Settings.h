@@ -58,9 +58,15 @@ public:
 
     bool displayFps() const;
 
+    bool displayResourceStatistics() const;
+
+    // Profiler records timings from start and shows them on screen
+    bool displayProfiler() const;
+
     bool worldMapFullscreen() const;
 
     bool displayMousePosition() const;
+    bool pickBuffer() const;
 
     bool audioEnabled() const;
     void setVoiceVolume(double _voiceVolume);
@@ -108,6 +114,11 @@ public:
     unsigned int scale() const;
     void setFullscreen(bool _fullscreen);
     bool fullscreen() const;
+    void setVsync(bool _vsync);
+    bool vsync() const;
+    // Frames per second, 0 means display refresh rate when vsync is not available and no limit otherwise
+    void setFrameCap(unsigned int _frameCap);
+    unsigned int frameCap() const;
     void setAudioBufferSize(int _audioBufferSize);
     int audioBufferSize() const;
 
@@ -117,12 +128,17 @@ private:
     std::string _initLocation = "klamall";
     bool _forceLocation = false;
     bool _displayFps = true;
+    bool _displayResourceStatistics = false;
+    bool _displayProfiler = false;
     bool _worldMapFullscreen = false;
     bool _displayMousePosition = true;
+    bool _pickBuffer = true;
     std::string _loggerLevel = "info";
     bool _loggerColors = true;
     unsigned int _scale = 0;
     bool _fullscreen = false;
+    bool _vsync = true;
+    unsigned int _frameCap = 0;
 
     double _brightness = 1.0;
     unsigned int _gameDifficulty = 1;
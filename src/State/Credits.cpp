@@ -18,6 +18,7 @@
  */
 
 // C++ standard includes
+#include <algorithm>
 #include <sstream>
 
 // Falltergeist includes
@@ -26,6 +27,7 @@
 #include "../Event/Mouse.h"
 #include "../Event/State.h"
 #include "../Font.h"
+#include "../Game/Clock.h"
 #include "../Game/Game.h"
 #include "../UI/TextArea.h"
 #include "../Input/Mouse.h"
@@ -103,14 +105,20 @@ void Credits::init()
         _lines.push_back(tx);
         y += tx->textSize().height() + cur_font->verticalGap() + additionalGap;
     }
-    _lastTicks=SDL_GetTicks();
+    _lastTicks=Game::getInstance()->clock()->ticks();
+}
+
+unsigned int Credits::nextWakeUp()
+{
+    // Lines move by one pixel every 50 ms
+    return std::min(State::nextWakeUp(), (unsigned int)_lastTicks + 51);
 }
 
 void Credits::think()
 {
     State::think();
 
-    unsigned long int nt = SDL_GetTicks();
+    unsigned long int nt = Game::getInstance()->clock()->ticks();
     if (nt - _lastTicks > 50)
     {
         _position.ry() -= 1;
@@ -44,6 +44,7 @@ public:
 
     void init() override;
     void think() override;
+    unsigned int nextWakeUp() override;
     void handle(Event::Event* event) override;
 
     void onCreditsFinished();
@@ -24,29 +24,36 @@
 #include <algorithm>
 #include <cmath>
 #include <list>
+#include <set>
 
 // Falltergeist includes
 #include "../Audio/Mixer.h"
 #include "../Base/StlFeatures.h"
 #include "../Event/Mouse.h"
 #include "../Exception.h"
+#include "../Game/Clock.h"
 #include "../Game/ContainerItemObject.h"
 #include "../Game/Defines.h"
 #include "../Game/DoorSceneryObject.h"
 #include "../Game/DudeObject.h"
 #include "../Game/ExitMiscObject.h"
 #include "../Game/Game.h"
+#include "../Game/Location.h"
 #include "../Game/Object.h"
 #include "../Game/ObjectFactory.h"
 #include "../Game/Time.h"
 #include "../Game/WeaponItemObject.h"
 #include "../Graphics/Renderer.h"
+#include "../Graphics/Texture.h"
+#include "../Graphics/TextureAtlas.h"
 #include "../Input/Mouse.h"
 #include "../LocationCamera.h"
 #include "../Logger.h"
 #include "../PathFinding/Hexagon.h"
 #include "../PathFinding/HexagonGrid.h"
+#include "../Profiler.h"
 #include "../Point.h"
+#include "../ResourceLoader.h"
 #include "../ResourceManager.h"
 #include "../Settings.h"
 #include "../State/CursorDropdown.h"
@@ -60,6 +67,7 @@
 #include "../UI/SmallCounter.h"
 #include "../UI/TextArea.h"
 #include "../UI/Tile.h"
+#include "../UI/TileAtlas.h"
 #include "../UI/TileMap.h"
 #include "../VM/VM.h"
 
@@ -78,6 +86,16 @@ using namespace Base;
 
 const int Location::DROPDOWN_DELAY = 350;
 const int Location::KEYBOARD_SCROLL_STEP = 35;
+const int Location::PREFETCH_INTERVAL = 500;
+// Time spent on building background elevations per frame, milliseconds
+const unsigned int Location::LAYER_BUILD_TIME = 2;
+// Exit grids farther than this (in hexagons) from where player is heading to are not prefetched
+const unsigned int Location::PREFETCH_DISTANCE = 40;
+const unsigned int Location::PREFETCH_MAPS = 2;
+const int Location::HIT_GRID_CELL_SIZE = 64;
+const int Location::PICK_BUFFER_SCALE = 2;
+// No speculative loading once resident resources take more than this
+const uint64_t Location::PREFETCH_MEMORY_BUDGET = 256 * 1024 * 1024;
 
 Location::Location() : State()
 {
@@ -119,12 +137,36 @@ void Location::onStateDeactivate(Event::State* event)
     _actionCursorTicks = 0;
 }
 
-void Location::setLocation(const std::string& name)
+void Location::setLocation(const std::string& name, int position, int elevation, int orientation)
 {
-    _floor = make_unique<UI::TileMap>();
-    _roof = make_unique<UI::TileMap>();
-    _hexagonGrid = make_unique<HexagonGrid>();
-    _objects.clear();
+    auto statistics = ResourceManager::getInstance()->statistics();
+    auto countersBefore = statistics->counters();
+    auto ticks = SDL_GetTicks();
+
+    // Player keeps pointers to hexagons of previous map
+    auto player = Game::getInstance()->player();
+    player->stopMovement();
+    player->setHexagon(nullptr);
+
+    _objectUnderCursor = nullptr;
+    _actionCursorLastObject = nullptr;
+    _actionCursorTicks = 0;
+    _lastClickedTile = 0;
+    _locationEnter = true;
+    _locationScript.reset();
+    _MVARS.clear();
+    _prefetchedMaps.clear();
+
+    _clearHitGrid();
+    _mouseObjects.clear();
+    _handledObjects.clear();
+    _pickBufferValid = false;
+    _layer = nullptr;
+    _layers.clear();
+    _tileAtlas.reset();
+
+    // Sprites of previous map are evicted, the ones still used are placed again on next draw
+    Game::getInstance()->renderer()->atlas()->clear();
 
     auto mapFile = ResourceManager::getInstance()->mapFileType(name);
 
@@ -134,11 +176,19 @@ void Location::setLocation(const std::string& name)
         Logger::warning() << "No such map: `" << name << "`; using default map" << std::endl;
         mapFile = ResourceManager::getInstance()->mapFileType("maps/" + defaultSettings->initialLocation() + ".map");
     }
+    _mapFile = mapFile;
+    _mapFilename = mapFile->filename();
+    std::transform(_mapFilename.begin(), _mapFilename.end(), _mapFilename.begin(), ::tolower);
 
-    _currentElevation = mapFile->defaultElevation();
-
-    // Set camera position on default
-    camera()->setCenter(hexagonGrid()->at(mapFile->defaultPosition())->position());
+    _currentElevation = (elevation >= 0 && (unsigned int)elevation < mapFile->elevations()->size()) ? elevation : mapFile->defaultElevation();
+    if (position < 0 || position >= 200*200)
+    {
+        position = mapFile->defaultPosition();
+    }
+    if (orientation < 0)
+    {
+        orientation = mapFile->defaultOrientation();
+    }
 
     // Initialize MAP vars
     if (mapFile->MVARS()->size() > 0)
@@ -151,73 +201,23 @@ void Location::setLocation(const std::string& name)
         }
     }
 
-    auto mapObjects = mapFile->elevations()->at(_currentElevation)->objects();
-
-    auto ticks = SDL_GetTicks();
-    // @todo remove old objects from hexagonal grid
-    for (auto mapObject : *mapObjects)
+    // Current elevation is built right now, the others are built in background by think()
+    for (unsigned int i = 0; i != mapFile->elevations()->size(); ++i)
     {
-        auto object = Game::ObjectFactory::getInstance()->createObject(mapObject->PID());
-        if (!object)
-        {
-            Logger::error() << "Location::setLocation() - can't create object with PID: " << mapObject->PID() << std::endl;
-            continue;
-        }
-
-        object->setFID(mapObject->FID());
-        object->setElevation(_currentElevation);
-        object->setOrientation(mapObject->orientation());
-        object->setLightRadius(mapObject->lightRadius());
-        object->setLightIntensity(mapObject->lightIntensity());
-        object->setFlags(mapObject->flags());
-
-        if (auto exitGrid = dynamic_cast<Game::ExitMiscObject*>(object))
-        {
-            exitGrid->setExitMapNumber(mapObject->exitMap());
-            exitGrid->setExitElevationNumber(mapObject->exitElevation());
-            exitGrid->setExitHexagonNumber(mapObject->exitPosition());
-            exitGrid->setExitDirection(mapObject->exitOrientation());
-        }
-
-        if (auto container = dynamic_cast<Game::ContainerItemObject*>(object))
-        {
-            for (auto child : *mapObject->children())
-            {
-                auto item = dynamic_cast<Game::ItemObject*>(Game::ObjectFactory::getInstance()->createObject(child->PID()));
-                if (!item)
-                {
-                    Logger::error() << "Location::setLocation() - can't create object with PID: " << child->PID() << std::endl;
-                    continue;
-                }
-                item->setAmount(child->ammount());
-                container->inventory()->push_back(item);
-            }
-        }
-
-        if (mapObject->scriptId() > 0)
-        {
-            auto intFile = ResourceManager::getInstance()->intFileType(mapObject->scriptId());
-            if (intFile) object->setScript(new VM(intFile,object));
-        }
-        if (mapObject->mapScriptId() > 0 && mapObject->mapScriptId() != mapObject->scriptId())
-        {
-            auto intFile = ResourceManager::getInstance()->intFileType(mapObject->mapScriptId());
-            if (intFile) object->setScript(new VM(intFile, object));
-        }
-
-        auto hexagon = hexagonGrid()->at(mapObject->hexPosition());
-        Location::moveObjectToHexagon(object, hexagon);
-
-        _objects.emplace_back(object);
+        _layers.push_back(make_unique<Layer>());
     }
-    Logger::info("GAME") << "Objects loaded in " << (SDL_GetTicks() - ticks) << std::endl;
+    _layer = _layers.at(_currentElevation).get();
+    _buildLayer(_currentElevation, 0);
+
+    camera()->setCenter(hexagonGrid()->at(position)->position());
 
     // Adding dude
     {
-        auto player = Game::getInstance()->player();
-        player->setArmorSlot(nullptr);
         // Just for testing
+        if (!_testItemsAdded)
         {
+            _testItemsAdded = true;
+            player->setArmorSlot(nullptr);
             player->inventory()->push_back((Game::ItemObject*)Game::ObjectFactory::getInstance()->createObject(0x00000003)); // power armor
             player->inventory()->push_back((Game::ItemObject*)Game::ObjectFactory::getInstance()->createObject(0x0000004A)); // leather jacket
             player->inventory()->push_back((Game::ItemObject*)Game::ObjectFactory::getInstance()->createObject(0x00000011)); // combat armor
@@ -228,13 +228,15 @@ void Location::setLocation(const std::string& name)
             player->setRightHandSlot(dynamic_cast<Game::WeaponItemObject*>(rightHand));
         }
         player->setPID(0x01000001);
-        player->setOrientation(mapFile->defaultOrientation());
+        player->setOrientation(orientation);
+        player->setElevation(_currentElevation);
 
         // Player script
         player->setScript(new VM(ResourceManager::getInstance()->intFileType(0), player));
 
-        auto hexagon = hexagonGrid()->at(mapFile->defaultPosition());
+        auto hexagon = hexagonGrid()->at(position);
         Location::moveObjectToHexagon(player, hexagon);
+        _playerHexagon = hexagon;
     }
 
     // Location script
@@ -243,8 +245,109 @@ void Location::setLocation(const std::string& name)
         _locationScript = make_unique<VM>(ResourceManager::getInstance()->intFileType(mapFile->scriptId()-1), nullptr);
     }
 
-    // Generates floor and roof images
+    Logger::info("GAME") << "Location " << name << " loaded in " << (SDL_GetTicks() - ticks) << " ms" << std::endl;
+    for (auto& counters : ResourceStatistics::difference(countersBefore, statistics->counters()))
+    {
+        auto& value = counters.second;
+        if (value.misses == 0 && value.hits == 0) continue;
+        Logger::info("GAME") << "    " << counters.first << ": "
+                             << value.misses << " loaded, " << value.hits << " cached, "
+                             << value.bytesRead / 1024 << " KB read, " << value.bytesInflated / 1024 << " KB inflated, "
+                             << value.decodeTime / 1000 << " ms decoding" << std::endl;
+    }
+
+    // Everything needed to get from start to the first playable location is known now
+    ResourceManager::getInstance()->saveProfile();
+
+    _prefetchTicks = 0;
+}
+
+void Location::setElevation(unsigned int elevation, int position, int orientation)
+{
+    if (elevation >= _layers.size())
+    {
+        throw Exception("Location::setElevation() - elevation out of range: " + std::to_string(elevation));
+    }
+
+    auto player = Game::getInstance()->player();
+    if (position < 0 || position >= 200*200)
     {
+        position = player->hexagon()->number();
+    }
+
+    // Normally the layer is finished in background long before player gets there
+    _buildLayer(elevation, 0);
+
+    // Player is removed from the previous layer's hexagon, that grid is kept alive
+    player->stopMovement();
+    _clearHitGrid();
+    _mouseObjects.clear();
+    _handledObjects.clear();
+    _pickBufferValid = false;
+    _layer = _layers.at(elevation).get();
+    _currentElevation = elevation;
+    _objectUnderCursor = nullptr;
+    _actionCursorLastObject = nullptr;
+    _actionCursorTicks = 0;
+
+    auto hexagon = hexagonGrid()->at(position);
+    Location::moveObjectToHexagon(player, hexagon);
+    _playerHexagon = hexagon;
+    player->setElevation(elevation);
+    if (orientation >= 0)
+    {
+        player->setOrientation(orientation);
+    }
+    centerCameraAtHexagon(hexagon);
+
+    // On map enter scripts of current elevation are started by think()
+    if (!_locationEnter && !_layer->scriptsStarted)
+    {
+        _layer->scriptsStarted = true;
+        for (auto& object : _layer->objects)
+        {
+            if (object->script())
+            {
+                object->script()->initialize();
+            }
+        }
+        for (auto it = _layer->objects.rbegin(); it != _layer->objects.rend(); ++it)
+        {
+            (*it)->map_enter_p_proc();
+        }
+    }
+}
+
+bool Location::_buildLayer(unsigned int elevation, unsigned int deadline)
+{
+    auto layer = _layers.at(elevation).get();
+    if (layer->built) return true;
+
+    auto mapElevation = _mapFile->elevations()->at(elevation);
+    if (!layer->hexagonGrid)
+    {
+        layer->hexagonGrid = make_unique<HexagonGrid>();
+
+        if (!_tileAtlas)
+        {
+            _tileAtlas = make_unique<UI::TileAtlas>();
+            for (auto otherElevation : *_mapFile->elevations())
+            {
+                for (auto tileNum : *otherElevation->floorTiles())
+                {
+                    if (tileNum > 1) _tileAtlas->add(tileNum);
+                }
+                for (auto tileNum : *otherElevation->roofTiles())
+                {
+                    if (tileNum > 1) _tileAtlas->add(tileNum);
+                }
+            }
+        }
+        layer->floor = make_unique<UI::TileMap>(_tileAtlas.get());
+        layer->roof = make_unique<UI::TileMap>(_tileAtlas.get());
+
+        // Generates floor and roof images
+        std::set<unsigned int> tiles;
         for (unsigned int i = 0; i != 100*100; ++i)
         {
             unsigned int tileX = std::ceil(((double)i)/100);
@@ -252,19 +355,205 @@ void Location::setLocation(const std::string& name)
             unsigned int x = (100 - tileY - 1)*48 + 32*(tileX - 1);
             unsigned int y = tileX*24 +(tileY - 1)*12 + 1;
 
-            unsigned int tileNum = mapFile->elevations()->at(_currentElevation)->floorTiles()->at(i);
+            unsigned int tileNum = mapElevation->floorTiles()->at(i);
             if (tileNum > 1)
             {
-                _floor->tiles().push_back(make_unique<UI::Tile>(tileNum, Point(x, y)));
+                layer->floor->tiles().push_back(make_unique<UI::Tile>(tileNum, Point(x, y)));
+                tiles.insert(tileNum);
             }
 
-            tileNum = mapFile->elevations()->at(_currentElevation)->roofTiles()->at(i);
+            tileNum = mapElevation->roofTiles()->at(i);
             if (tileNum > 1)
             {
-                _roof->tiles().push_back(make_unique<UI::Tile>(tileNum, Point(x, y - 104)));
+                layer->roof->tiles().push_back(make_unique<UI::Tile>(tileNum, Point(x, y - 104)));
+                tiles.insert(tileNum);
+            }
+        }
+
+        // Tile frames are decoded by loader while objects are created
+        if (deadline)
+        {
+            auto tilesLst = ResourceManager::getInstance()->lstFileType("art/tiles/tiles.lst");
+            for (auto tileNum : tiles)
+            {
+                if (tileNum < tilesLst->strings()->size())
+                {
+                    layer->pendingTiles.push_back("art/tiles/" + tilesLst->strings()->at(tileNum));
+                    ResourceManager::getInstance()->loader()->request(layer->pendingTiles.back(), true);
+                }
+            }
+        }
+    }
+
+    auto mapObjects = mapElevation->objects();
+    while (layer->mapObjectsCreated < mapObjects->size())
+    {
+        if (deadline && SDL_GetTicks() >= deadline) return false;
+        _createObject(layer, mapObjects->at(layer->mapObjectsCreated++), elevation);
+    }
+
+    // Loader may be busy with prefetches too, only tiles of this layer are waited for
+    auto loader = ResourceManager::getInstance()->loader();
+    auto& pendingTiles = layer->pendingTiles;
+    pendingTiles.erase(std::remove_if(pendingTiles.begin(), pendingTiles.end(), [loader](const std::string& filename)
+    {
+        return !loader->pending(filename);
+    }), pendingTiles.end());
+    if (deadline && (SDL_GetTicks() >= deadline || !pendingTiles.empty())) return false;
+    pendingTiles.clear();
+    layer->floor->prepare();
+    layer->roof->prepare();
+    layer->built = true;
+    return true;
+}
+
+void Location::_buildLayers()
+{
+    auto deadline = SDL_GetTicks() + LAYER_BUILD_TIME;
+    for (unsigned int i = 0; i != _layers.size(); ++i)
+    {
+        if (!_buildLayer(i, deadline)) return;
+    }
+}
+
+void Location::_createObject(Layer* layer, libfalltergeist::Map::Object* mapObject, unsigned int elevation)
+{
+    auto object = Game::ObjectFactory::getInstance()->createObject(mapObject->PID());
+    if (!object)
+    {
+        Logger::error() << "Location::_createObject() - can't create object with PID: " << mapObject->PID() << std::endl;
+        return;
+    }
+
+    object->setFID(mapObject->FID());
+    object->setElevation(elevation);
+    object->setOrientation(mapObject->orientation());
+    object->setLightRadius(mapObject->lightRadius());
+    object->setLightIntensity(mapObject->lightIntensity());
+    object->setFlags(mapObject->flags());
+
+    if (auto exitGrid = dynamic_cast<Game::ExitMiscObject*>(object))
+    {
+        exitGrid->setExitMapNumber(mapObject->exitMap());
+        exitGrid->setExitElevationNumber(mapObject->exitElevation());
+        exitGrid->setExitHexagonNumber(mapObject->exitPosition());
+        exitGrid->setExitDirection(mapObject->exitOrientation());
+        layer->exitGrids.push_back(exitGrid);
+    }
+
+    if (auto container = dynamic_cast<Game::ContainerItemObject*>(object))
+    {
+        for (auto child : *mapObject->children())
+        {
+            auto item = dynamic_cast<Game::ItemObject*>(Game::ObjectFactory::getInstance()->createObject(child->PID()));
+            if (!item)
+            {
+                Logger::error() << "Location::_createObject() - can't create object with PID: " << child->PID() << std::endl;
+                continue;
             }
+            item->setAmount(child->ammount());
+            container->inventory()->push_back(item);
         }
     }
+
+    if (mapObject->scriptId() > 0)
+    {
+        auto intFile = ResourceManager::getInstance()->intFileType(mapObject->scriptId());
+        if (intFile) object->setScript(new VM(intFile,object));
+    }
+    if (mapObject->mapScriptId() > 0 && mapObject->mapScriptId() != mapObject->scriptId())
+    {
+        auto intFile = ResourceManager::getInstance()->intFileType(mapObject->mapScriptId());
+        if (intFile) object->setScript(new VM(intFile, object));
+    }
+
+    auto hexagon = layer->hexagonGrid->at(mapObject->hexPosition());
+    Location::moveObjectToHexagon(object, hexagon);
+
+    layer->objects.emplace_back(object);
+}
+
+std::string Location::_exitMapFilename(int number)
+{
+    // Negative numbers are worldmap and town map exits
+    if (number < 0) return "";
+
+    auto it = _exitMapFilenames.find(number);
+    if (it != _exitMapFilenames.end()) return it->second;
+
+    std::unique_ptr<Game::Location> location(ResourceManager::getInstance()->gameLocation(number));
+    std::string filename = location ? location->filename() : "";
+    std::transform(filename.begin(), filename.end(), filename.begin(), ::tolower);
+    _exitMapFilenames.insert(std::make_pair(number, filename));
+    return filename;
+}
+
+void Location::_prefetchExitMaps()
+{
+    auto player = Game::getInstance()->player();
+    if (!player->hexagon() || _layer->exitGrids.empty()) return;
+
+    auto resources = ResourceManager::getInstance();
+    if (resources->statistics()->total().residentSize > PREFETCH_MEMORY_BUDGET) return;
+
+    // While walking, the end of the path tells where player is heading to
+    auto from = player->movementQueue()->empty() ? player->hexagon() : player->movementQueue()->front();
+
+    // Exit grids are lines of hexagons, the nearest one counts for every target map
+    std::map<std::string, std::pair<unsigned int, int>> targets; // filename -> distance, elevation
+    for (auto exitGrid : _layer->exitGrids)
+    {
+        auto filename = _exitMapFilename(exitGrid->exitMapNumber());
+        if (filename.empty() || filename == _mapFilename || !exitGrid->hexagon()) continue;
+
+        unsigned int distance = hexagonGrid()->distance(from, exitGrid->hexagon());
+        auto it = targets.find(filename);
+        if (distance <= PREFETCH_DISTANCE && (it == targets.end() || distance < it->second.first))
+        {
+            targets[filename] = std::make_pair(distance, exitGrid->exitElevationNumber());
+        }
+    }
+
+    std::vector<std::pair<unsigned int, std::string>> ranking;
+    for (auto& target : targets)
+    {
+        ranking.push_back(std::make_pair(target.second.first, target.first));
+    }
+    std::sort(ranking.begin(), ranking.end());
+    if (ranking.size() > PREFETCH_MAPS) ranking.resize(PREFETCH_MAPS);
+
+    for (auto& target : ranking)
+    {
+        if (!_prefetchedMaps.insert(target.second).second) continue;
+
+        Logger::debug("LOCATION") << "Prefetching " << target.second << ", exit grid is " << target.first << " hexagons away" << std::endl;
+        resources->loader()->requestMap(target.second, std::max(0, targets[target.second].second));
+    }
+}
+
+bool Location::_useExitGrid(Game::ExitMiscObject* exitGrid)
+{
+    auto filename = _exitMapFilename(exitGrid->exitMapNumber());
+    if (filename.empty())
+    {
+        // @TODO: worldmap and town map
+        Logger::info("LOCATION") << "Exit grid to map " << exitGrid->exitMapNumber() << " is not supported" << std::endl;
+        return false;
+    }
+
+    // Exit grid is destroyed together with current map
+    int position = exitGrid->exitHexagonNumber();
+    int elevation = exitGrid->exitElevationNumber();
+    int orientation = exitGrid->exitDirection();
+    if (filename == _mapFilename && elevation >= 0 && (unsigned int)elevation < _layers.size())
+    {
+        setElevation(elevation, position, orientation);
+    }
+    else
+    {
+        setLocation(filename, position, elevation, orientation);
+    }
+    return true;
 }
 
 std::vector<Input::Mouse::Icon> Location::getCursorIconsForObject(Game::Object* object)
@@ -312,7 +601,7 @@ void Location::onObjectMouseEvent(Event::Event* event, Game::Object* object)
     if (event->name() == "mouseleftdown")
     {
         _objectUnderCursor = object;
-        _actionCursorTicks = SDL_GetTicks();
+        _actionCursorTicks = Game::getInstance()->clock()->ticks();
         _actionCursorButtonPressed = true;
     }
     else if (event->name() == "mouseleftclick")
@@ -340,7 +629,7 @@ void Location::onObjectHover(Event::Event* event, Game::Object* object)
             _objectUnderCursor = object;
             _actionCursorButtonPressed = false;
         }
-        _actionCursorTicks = SDL_GetTicks();
+        _actionCursorTicks = Game::getInstance()->clock()->ticks();
     }
 }
 
@@ -350,10 +639,22 @@ void Location::onBackgroundClick(Event::Mouse* event)
 
 void Location::render()
 {
-    _floor->render();
+    FALLTERGEIST_PROFILE("Location::render");
+    _layer->floor->render();
+
+    auto renderer = Game::getInstance()->renderer();
+    unsigned int columns = (renderer->width() + HIT_GRID_CELL_SIZE - 1) / HIT_GRID_CELL_SIZE;
+    unsigned int rows = (renderer->height() + HIT_GRID_CELL_SIZE - 1) / HIT_GRID_CELL_SIZE;
+    if (columns != _hitGridColumns || rows != _hitGridRows)
+    {
+        _hitGridColumns = columns;
+        _hitGridRows = rows;
+        _hitGrid.resize(columns * rows);
+    }
+    _clearHitGrid();
 
     //render only flat objects first
-    for (auto hexagon : _hexagonGrid->hexagons())
+    for (auto hexagon : _layer->hexagonGrid->hexagons())
     {
         hexagon->setInRender(false);
         for (auto object : *hexagon->objects())
@@ -364,13 +665,14 @@ void Location::render()
                 if (object->inRender())
                 {
                     hexagon->setInRender(true);
+                    _addDrawnObject(object);
                 }
             }
         }
     }
 
     // now render all other objects
-    for (auto hexagon : _hexagonGrid->hexagons())
+    for (auto hexagon : _layer->hexagonGrid->hexagons())
     {
         hexagon->setInRender(false);
         for (auto object : *hexagon->objects())
@@ -381,19 +683,27 @@ void Location::render()
                 if (object->inRender())
                 {
                     hexagon->setInRender(true);
+                    _addDrawnObject(object);
                 }
             }
         }
     }
 
-    for (auto hexagon : _hexagonGrid->hexagons())
+    // Roof over player is hidden, roof tiles are raised above the floor ones they cover
+    auto player = Game::getInstance()->player();
+    if (player && player->hexagon())
+    {
+        _layer->roof->hideChunksAt(player->hexagon()->position() - Point(0, 104));
+    }
+    _layer->roof->render();
+
+    for (auto hexagon : _layer->hexagonGrid->hexagons())
     {
         for (auto object : *hexagon->objects())
         {
             object->renderText();
         }
     }
-    //_roof->render();
     if (active())
     {
         _hexagonInfo->render();
@@ -402,25 +712,54 @@ void Location::render()
     _playerPanel->render();
 }
 
+unsigned int Location::nextWakeUp()
+{
+    // Objects, scripts and scrolling are too many to track, location is simulated at full rate
+    return Game::getInstance()->clock()->ticks();
+}
+
+void Location::thinkFrame()
+{
+    _buildLayers();
+}
+
 void Location::think()
 {
+    FALLTERGEIST_PROFILE("Location::think");
+    auto ticks = Game::getInstance()->clock()->ticks();
+
     Game::getInstance()->gameTime()->think();
+    _camera->think();
 
     _playerPanel->think();
 
     auto player = Game::getInstance()->player();
 
-    for (auto& object : _objects)
+    for (auto& object : _layer->objects)
     {
         object->think();
     }
     player->think();
 
-    // location scrolling
-    if (_scrollTicks + 10 < SDL_GetTicks())
+    if (_playerHexagon != player->hexagon())
+    {
+        _playerHexagon = player->hexagon();
+        for (auto object : *_playerHexagon->objects())
+        {
+            auto exitGrid = dynamic_cast<Game::ExitMiscObject*>(object);
+            if (exitGrid && _useExitGrid(exitGrid)) break;
+        }
+    }
+
+    if (_prefetchTicks + PREFETCH_INTERVAL < ticks)
+    {
+        _prefetchTicks = ticks;
+        _prefetchExitMaps();
+    }
+
+    // location scrolling, 5 pixels per 10 ms
     {
-        _scrollTicks = SDL_GetTicks();
-        int scrollDelta = 5;
+        int scrollDelta = 5 * Game::getInstance()->clock()->delta() / 10;
 
         //Game::getInstance()->mouse()->setType(Mouse::ACTION);
 
@@ -428,7 +767,7 @@ void Location::think()
             _scrollLeft ? -scrollDelta : (_scrollRight ? scrollDelta : 0),
             _scrollTop ? -scrollDelta : (_scrollBottom ? scrollDelta : 0)
         );
-        _camera->setCenter(_camera->center() + pScrollDelta);
+        _camera->scroll(pScrollDelta);
 
         auto mouse = Game::getInstance()->mouse();
 
@@ -466,10 +805,11 @@ void Location::think()
     if (_locationEnter)
     {
         _locationEnter = false;
+        _layer->scriptsStarted = true;
 
         if (_locationScript) _locationScript->initialize();
 
-        for (auto& object : _objects)
+        for (auto& object : _layer->objects)
         {
             if (object->script())
             {
@@ -487,21 +827,21 @@ void Location::think()
         // If we use normal iterators, some exported variables are not initialized on the moment
         // when script is called
         player->map_enter_p_proc();
-        for (auto it = _objects.rbegin(); it != _objects.rend(); ++it)
+        for (auto it = _layer->objects.rbegin(); it != _layer->objects.rend(); ++it)
         {
             (*it)->map_enter_p_proc();
         }
     }
     else
     {
-        if (_scriptsTicks + 10000 < SDL_GetTicks())
+        if (_scriptsTicks + 10000 < ticks)
         {
-            _scriptsTicks = SDL_GetTicks();
+            _scriptsTicks = ticks;
             if (_locationScript)
             {
                 _locationScript->call("map_update_p_proc");
             }
-            for (auto& object : _objects)
+            for (auto& object : _layer->objects)
             {
                 object->map_update_p_proc();
             }
@@ -510,7 +850,7 @@ void Location::think()
     }
 
     // action cursor stuff
-    if (_objectUnderCursor && _actionCursorTicks && _actionCursorTicks + DROPDOWN_DELAY < SDL_GetTicks())
+    if (_objectUnderCursor && _actionCursorTicks && _actionCursorTicks + DROPDOWN_DELAY < ticks)
     {
         auto game = Game::getInstance();
         if (_actionCursorButtonPressed || game->mouse()->state() == Input::Mouse::Cursor::ACTION)
@@ -636,20 +976,6 @@ void Location::handle(Event::Event* event)
                     mouse->ui()->setPosition(hexagon->position() - _camera->topLeft());
                     break;
                 }
-                case Input::Mouse::Cursor::ACTION:
-                {
-                    // optimization to prevent FPS drops on mouse move
-                    auto ticks = SDL_GetTicks();
-                    if (ticks - _mouseMoveTicks < 50)
-                    {
-                        event->setHandled(true);
-                    }
-                    else
-                    {
-                        _mouseMoveTicks = ticks;
-                    }
-                    break;
-                }
                 default:
                     break;
             }
@@ -703,20 +1029,264 @@ void Location::handle(Event::Event* event)
         }
         event->setHandled(true);
     }
-    auto hexagons = _hexagonGrid->hexagons();
-    for (auto it = hexagons.rbegin(); it != hexagons.rend(); ++it)
+
+    if (auto mouseEvent = dynamic_cast<Event::Mouse*>(event))
+    {
+        if (!event->handled()) _handleObjects(mouseEvent);
+    }
+}
+
+void Location::_clearHitGrid()
+{
+    _hitGridGeneration++;
+    _drawnObjects.clear();
+    _drawnRects.clear();
+    for (auto& cell : _hitGrid)
     {
-        Hexagon* hexagon = *it;
-        if (!hexagon->inRender()) continue;
-        auto objects = hexagon->objects();
-        for (auto itt = objects->rbegin(); itt != objects->rend(); ++itt)
+        cell.clear();
+    }
+}
+
+void Location::_addDrawnObject(Game::Object* object)
+{
+    auto ui = object->ui();
+    if (!ui) return;
+
+    // Animations are hit at position() + offset(), other elements at position(). Rectangle covers both
+    Point position = ui->position();
+    Point shifted = position + ui->offset();
+    Size size = ui->size();
+    SDL_Rect rect;
+    rect.x = std::min(position.x(), shifted.x());
+    rect.y = std::min(position.y(), shifted.y());
+    rect.w = std::max(position.x(), shifted.x()) + size.width() - rect.x;
+    rect.h = std::max(position.y(), shifted.y()) + size.height() - rect.y;
+    if (rect.w <= 0 || rect.h <= 0) return;
+
+    int left = std::max(0, rect.x / HIT_GRID_CELL_SIZE);
+    int top = std::max(0, rect.y / HIT_GRID_CELL_SIZE);
+    int right = std::min((int)_hitGridColumns - 1, (rect.x + rect.w - 1) / HIT_GRID_CELL_SIZE);
+    int bottom = std::min((int)_hitGridRows - 1, (rect.y + rect.h - 1) / HIT_GRID_CELL_SIZE);
+    if (left > right || top > bottom) return;
+
+    unsigned int index = _drawnObjects.size();
+    _drawnObjects.push_back(object);
+    _drawnRects.push_back(rect);
+    for (int y = top; y <= bottom; ++y)
+    {
+        for (int x = left; x <= right; ++x)
+        {
+            _hitGrid[y * _hitGridColumns + x].push_back(index);
+        }
+    }
+}
+
+void Location::_handleObjects(Event::Mouse* event)
+{
+    _handledObjects.clear();
+    auto generation = _hitGridGeneration;
+    Point position = event->position();
+    int column = position.x() / HIT_GRID_CELL_SIZE;
+    int row = position.y() / HIT_GRID_CELL_SIZE;
+
+    bool walkGrid = true;
+    if (Game::getInstance()->settings()->pickBuffer())
+    {
+        // Topmost object under cursor is read from buffer, objects behind it need no pixel tests
+        auto object = _pickObject(position);
+        if (object)
         {
-            if (event->handled()) return;
-            auto object = *itt;
-            if (!object->inRender()) continue;
             object->handle(event);
+            if (generation != _hitGridGeneration) return;
+            _handledObjects.push_back(object);
+        }
+        // Buffer has lower resolution, so at edges the picked object may fail its own pixel test.
+        // Objects behind it get the event then
+        walkGrid = object && !event->handled();
+    }
+
+    if (walkGrid && position.x() >= 0 && position.y() >= 0 && column < (int)_hitGridColumns && row < (int)_hitGridRows)
+    {
+        // Front to back, pixel tests stop at first object hit
+        auto& cell = _hitGrid[row * _hitGridColumns + column];
+        for (unsigned int i = cell.size(); i-- > 0 && !event->handled();)
+        {
+            auto object = _drawnObjects[cell[i]];
+            auto& rect = _drawnRects[cell[i]];
+            if (!object || !Rect::inRect(position, Point(rect.x, rect.y), Size(rect.w, rect.h))) continue;
+            if (std::find(_handledObjects.begin(), _handledObjects.end(), object) != _handledObjects.end()) continue;
+
+            object->handle(event);
+            // Event handlers may switch map or elevation
+            if (generation != _hitGridGeneration) return;
+            _handledObjects.push_back(object);
+        }
+    }
+
+    // Objects left by cursor still need this event to emit mouseout, finish drag and so on
+    auto mouseObjects = _mouseObjects;
+    for (auto object : mouseObjects)
+    {
+        if (event->handled()) break;
+        if (std::find(_handledObjects.begin(), _handledObjects.end(), object) != _handledObjects.end()) continue;
+        // Destroyed by handler of previous object
+        if (std::find(_mouseObjects.begin(), _mouseObjects.end(), object) == _mouseObjects.end()) continue;
+
+        object->handle(event);
+        if (generation != _hitGridGeneration) return;
+        _handledObjects.push_back(object);
+    }
+
+    _mouseObjects.clear();
+    for (auto object : _handledObjects)
+    {
+        if (object->ui() && object->ui()->interacting())
+        {
+            _mouseObjects.push_back(object);
+        }
+    }
+}
+
+void Location::_updatePickBuffer()
+{
+    if (_pickBufferValid && _pickBufferGeneration == _hitGridGeneration) return;
+
+    auto renderer = Game::getInstance()->renderer();
+    unsigned int width = (renderer->width() + PICK_BUFFER_SCALE - 1) / PICK_BUFFER_SCALE;
+    unsigned int height = (renderer->height() + PICK_BUFFER_SCALE - 1) / PICK_BUFFER_SCALE;
+    if (width != _pickBufferWidth || height != _pickBufferHeight)
+    {
+        _pickBufferWidth = width;
+        _pickBufferHeight = height;
+        _pickBuffer.assign(width * height, 0);
+        _pickBufferValid = false;
+    }
+
+    std::vector<PickEntry> entries;
+    entries.reserve(_drawnObjects.size());
+    for (unsigned int i = 0; i != _drawnObjects.size(); ++i)
+    {
+        PickEntry entry = {_drawnObjects[i], _drawnRects[i], nullptr, 0};
+        if (auto ui = entry.object ? entry.object->ui() : nullptr)
+        {
+            // Animation frames share one texture, queues switch textures along with animations
+            entry.texture = ui->texture();
+            if (auto queue = dynamic_cast<UI::AnimationQueue*>(ui))
+            {
+                if (queue->currentAnimation()) entry.frame = queue->currentAnimation()->currentFrame();
+            }
+            else if (auto animation = dynamic_cast<UI::Animation*>(ui))
+            {
+                entry.frame = animation->currentFrame();
+            }
+        }
+        entries.push_back(entry);
+    }
+
+    // Objects masked by egg change their shape when player moves
+    Point eggPosition;
+    Size eggSize;
+    auto player = Game::getInstance()->player();
+    if (player && player->hexagon())
+    {
+        auto egg = ResourceManager::getInstance()->texture("data/egg.png");
+        eggPosition = player->hexagon()->position() - _camera->topLeft() - Point(63, 78) + player->ui()->offset();
+        eggSize = Size(egg->width(), egg->height());
+    }
+
+    SDL_Rect dirty = {0, 0, 0, 0};
+    auto addDirty = [&dirty](const SDL_Rect& rect)
+    {
+        if (SDL_RectEmpty(&dirty))
+        {
+            dirty = rect;
+        }
+        else
+        {
+            SDL_UnionRect(&dirty, &rect, &dirty);
+        }
+    };
+
+    if (!_pickBufferValid)
+    {
+        dirty = {0, 0, (int)width * PICK_BUFFER_SCALE, (int)height * PICK_BUFFER_SCALE};
+    }
+    else
+    {
+        for (unsigned int i = 0; i < std::max(entries.size(), _pickEntries.size()); ++i)
+        {
+            bool added = i < entries.size();
+            bool removed = i < _pickEntries.size();
+            if (added && removed)
+            {
+                auto& entry = entries[i];
+                auto& previous = _pickEntries[i];
+                if (entry.object == previous.object && SDL_RectEquals(&entry.rect, &previous.rect)
+                    && entry.texture == previous.texture && entry.frame == previous.frame) continue;
+            }
+            if (added) addDirty(entries[i].rect);
+            if (removed) addDirty(_pickEntries[i].rect);
+        }
+        if (eggPosition != _pickEggPosition)
+        {
+            addDirty({_pickEggPosition.x(), _pickEggPosition.y(), eggSize.width(), eggSize.height()});
+            addDirty({eggPosition.x(), eggPosition.y(), eggSize.width(), eggSize.height()});
         }
     }
+
+    // Stale blocks are cleared and drawn again by every object covering them, back to front
+    int left = std::max(0, dirty.x / PICK_BUFFER_SCALE);
+    int top = std::max(0, dirty.y / PICK_BUFFER_SCALE);
+    int right = std::min((int)width, (dirty.x + dirty.w + PICK_BUFFER_SCALE - 1) / PICK_BUFFER_SCALE);
+    int bottom = std::min((int)height, (dirty.y + dirty.h + PICK_BUFFER_SCALE - 1) / PICK_BUFFER_SCALE);
+    if (!SDL_RectEmpty(&dirty) && left < right && top < bottom)
+    {
+        for (int y = top; y != bottom; ++y)
+        {
+            std::fill(_pickBuffer.begin() + y * width + left, _pickBuffer.begin() + y * width + right, 0);
+        }
+
+        SDL_Rect region = {left * PICK_BUFFER_SCALE, top * PICK_BUFFER_SCALE, (right - left) * PICK_BUFFER_SCALE, (bottom - top) * PICK_BUFFER_SCALE};
+        for (unsigned int i = 0; i != entries.size(); ++i)
+        {
+            SDL_Rect area;
+            if (!entries[i].object || !SDL_IntersectRect(&entries[i].rect, &region, &area)) continue;
+
+            // Each block is sampled at its top left pixel
+            auto ui = entries[i].object->ui();
+            Point position = ui->position();
+            int blockRight = (area.x + area.w - 1) / PICK_BUFFER_SCALE;
+            int blockBottom = (area.y + area.h - 1) / PICK_BUFFER_SCALE;
+            for (int y = (area.y + PICK_BUFFER_SCALE - 1) / PICK_BUFFER_SCALE; y <= blockBottom; ++y)
+            {
+                for (int x = (area.x + PICK_BUFFER_SCALE - 1) / PICK_BUFFER_SCALE; x <= blockRight; ++x)
+                {
+                    if (ui->pixel(Point(x * PICK_BUFFER_SCALE, y * PICK_BUFFER_SCALE) - position))
+                    {
+                        _pickBuffer[y * width + x] = i + 1;
+                    }
+                }
+            }
+        }
+    }
+
+    _pickEntries.swap(entries);
+    _pickEggPosition = eggPosition;
+    _pickBufferGeneration = _hitGridGeneration;
+    _pickBufferValid = true;
+}
+
+Game::Object* Location::_pickObject(const Point& position)
+{
+    _updatePickBuffer();
+    if (position.x() < 0 || position.y() < 0) return nullptr;
+
+    unsigned int x = position.x() / PICK_BUFFER_SCALE;
+    unsigned int y = position.y() / PICK_BUFFER_SCALE;
+    if (x >= _pickBufferWidth || y >= _pickBufferHeight) return nullptr;
+
+    auto index = _pickBuffer[y * _pickBufferWidth + x];
+    return index ? _drawnObjects[index - 1] : nullptr;
 }
 
 void Location::onKeyDown(Event::Keyboard* event)
@@ -865,12 +1435,26 @@ void Location::destroyObject(Game::Object* object)
         }
     }
     if (_objectUnderCursor == object) _objectUnderCursor = nullptr;
-    for (auto it = _objects.begin(); it != _objects.end(); ++it)
+    std::replace(_drawnObjects.begin(), _drawnObjects.end(), object, (Game::Object*)nullptr);
+    // Address may be taken by a new object, so its blocks are drawn again
+    for (auto& entry : _pickEntries)
+    {
+        if (entry.object == object) entry.object = nullptr;
+    }
+    _mouseObjects.erase(std::remove(_mouseObjects.begin(), _mouseObjects.end(), object), _mouseObjects.end());
+    _handledObjects.erase(std::remove(_handledObjects.begin(), _handledObjects.end(), object), _handledObjects.end());
+    // Scripts may destroy objects of other elevations as well
+    for (auto& layer : _layers)
     {
-        if ((*it).get() == object)
+        auto& exitGrids = layer->exitGrids;
+        exitGrids.erase(std::remove(exitGrids.begin(), exitGrids.end(), object), exitGrids.end());
+        for (auto it = layer->objects.begin(); it != layer->objects.end(); ++it)
         {
-            _objects.erase(it);
-            break;
+            if ((*it).get() == object)
+            {
+                layer->objects.erase(it);
+                return;
+            }
         }
     }
 }
@@ -884,7 +1468,7 @@ void Location::centerCameraAtHexagon(int tileNum)
 {
     try
     {
-        centerCameraAtHexagon(_hexagonGrid->at((unsigned int)tileNum));
+        centerCameraAtHexagon(hexagonGrid()->at((unsigned int)tileNum));
     }
     catch (std::out_of_range ex)
     {
@@ -942,7 +1526,7 @@ void Location::displayMessage(const std::string& message)
 
 HexagonGrid* Location::hexagonGrid()
 {
-    return _hexagonGrid.get();
+    return _layer->hexagonGrid.get();
 }
 
 UI::PlayerPanel* Location::playerPanel()
@@ -21,7 +21,11 @@
 #define FALLTERGEIST_Location_H
 
 // C++ standard includes
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <set>
+#include <vector>
 
 // Falltergeist includes
 #include "State.h"
@@ -29,19 +33,35 @@
 #include "../UI/ImageButton.h"
 
 // Third party includes
+#include <SDL.h>
+
+namespace libfalltergeist
+{
+namespace Map
+{
+    class File;
+    class Object;
+}
+}
 
 namespace Falltergeist
 {
 namespace Game
 {
+    class ExitMiscObject;
     class Object;
 }
+namespace Graphics
+{
+    class Texture;
+}
 namespace UI
 {
     class Animation;
     class Image;
     class PlayerPanel;
     class Tile;
+    class TileAtlas;
     class TileMap;
 }
 class Hexagon;
@@ -66,10 +86,22 @@ public:
     Location();
     ~Location() override;
 
-    void setLocation(const std::string& name);
+    /**
+     * Loads map. Negative position, elevation and orientation mean map defaults.
+     */
+    void setLocation(const std::string& name, int position = -1, int elevation = -1, int orientation = -1);
+    /**
+     * Moves player to another elevation of current map. Negative position keeps hexagon number.
+     */
+    void setElevation(unsigned int elevation, int position = -1, int orientation = -1);
 
     void init();
     void think() override;
+    unsigned int nextWakeUp() override;
+    /**
+     * Called once per main loop pass instead of every logic step. Builds other elevations within LAYER_BUILD_TIME.
+     */
+    void thinkFrame();
     void handle(Event::Event* event) override;
     void render() override;
 
@@ -104,17 +136,44 @@ protected:
     
     static const int KEYBOARD_SCROLL_STEP;
     static const int DROPDOWN_DELAY;
+    static const int PREFETCH_INTERVAL;
+    static const unsigned int LAYER_BUILD_TIME;
+    static const unsigned int PREFETCH_DISTANCE;
+    static const unsigned int PREFETCH_MAPS;
+    static const uint64_t PREFETCH_MEMORY_BUDGET;
+    static const int HIT_GRID_CELL_SIZE;
+    static const int PICK_BUFFER_SCALE;
 
     // Timers
-    unsigned int _scrollTicks = 0;
     unsigned int _scriptsTicks = 0;
     unsigned int _actionCursorTicks = 0;
-    unsigned int _mouseMoveTicks = 0;
+    unsigned int _prefetchTicks = 0;
+
+    /**
+     * Scene of one map elevation. Switching elevation is a matter of switching current layer.
+     */
+    struct Layer
+    {
+        std::unique_ptr<HexagonGrid> hexagonGrid;
+        std::unique_ptr<UI::TileMap> floor;
+        std::unique_ptr<UI::TileMap> roof;
+        std::vector<std::unique_ptr<Game::Object>> objects;
+        // owned by objects
+        std::vector<Game::ExitMiscObject*> exitGrids;
+        // Tile files requested from loader in background, layer is finished once they are loaded
+        std::vector<std::string> pendingTiles;
+        unsigned int mapObjectsCreated = 0;
+        bool built = false;
+        bool scriptsStarted = false;
+    };
 
-    std::unique_ptr<HexagonGrid> _hexagonGrid;
+    // Tiles of all elevations, declared before layers so tile maps go away first
+    std::unique_ptr<UI::TileAtlas> _tileAtlas;
+    std::vector<std::unique_ptr<Layer>> _layers;
+    Layer* _layer = nullptr;
+    libfalltergeist::Map::File* _mapFile = nullptr;
+    std::string _mapFilename;
     std::unique_ptr<LocationCamera> _camera;
-    std::unique_ptr<UI::TileMap> _floor;
-    std::unique_ptr<UI::TileMap> _roof ;
     std::unique_ptr<VM> _locationScript;
     std::vector<int> _MVARS;
     std::map<std::string, VMStackValue> _EVARS;
@@ -127,17 +186,79 @@ protected:
     Game::Object* _actionCursorLastObject = NULL;
     bool _actionCursorButtonPressed = false;
     std::unique_ptr<UI::PlayerPanel> _playerPanel;
+    bool _testItemsAdded = false;
+
+    // Map number from maps.txt -> map filename, empty for worldmap and town map exits
+    std::map<int, std::string> _exitMapFilenames;
+    std::set<std::string> _prefetchedMaps;
+    // Exit grids are checked when player steps on another hexagon only
+    Hexagon* _playerHexagon = nullptr;
+
+    // Objects drawn in last frame, back to front, with screen rectangles they may be hit in
+    std::vector<Game::Object*> _drawnObjects;
+    std::vector<SDL_Rect> _drawnRects;
+    // Screen split into square cells, each holding indices of drawn objects covering it
+    std::vector<std::vector<unsigned int>> _hitGrid;
+    unsigned int _hitGridColumns = 0;
+    unsigned int _hitGridRows = 0;
+    // Changed whenever grid is cleared, so pointers taken before are known to be stale
+    unsigned int _hitGridGeneration = 0;
+    // Objects hovered, pressed or dragged after last mouse event
+    std::vector<Game::Object*> _mouseObjects;
+    // Objects the current mouse event was passed to
+    std::vector<Game::Object*> _handledObjects;
+
+    /**
+     * What pick buffer was drawn of. Entries that differ from last frame's ones mark stale parts of buffer.
+     */
+    struct PickEntry
+    {
+        Game::Object* object;
+        SDL_Rect rect;
+        Graphics::Texture* texture;
+        unsigned int frame;
+    };
+
+    // Index + 1 of topmost drawn object for each PICK_BUFFER_SCALE x PICK_BUFFER_SCALE block of screen, 0 for none
+    std::vector<uint32_t> _pickBuffer;
+    unsigned int _pickBufferWidth = 0;
+    unsigned int _pickBufferHeight = 0;
+    // Hit grid generation the buffer is up to date with
+    unsigned int _pickBufferGeneration = 0;
+    bool _pickBufferValid = false;
+    std::vector<PickEntry> _pickEntries;
+    Point _pickEggPosition;
 
     bool _scrollLeft = false;
     bool _scrollRight = false;
     bool _scrollTop = false;
     bool _scrollBottom = false;
 
-    std::vector<std::unique_ptr<Game::Object>> _objects;
     std::unique_ptr<UI::TextArea> _hexagonInfo;
     
     std::vector<Input::Mouse::Icon> getCursorIconsForObject(Game::Object* object);
 
+    std::string _exitMapFilename(int number);
+    void _prefetchExitMaps();
+    bool _useExitGrid(Game::ExitMiscObject* exitGrid);
+    /**
+     * Builds layer of given elevation until deadline (SDL ticks, 0 for no limit). Returns true when layer is complete.
+     */
+    bool _buildLayer(unsigned int elevation, unsigned int deadline);
+    void _buildLayers();
+    void _createObject(Layer* layer, libfalltergeist::Map::Object* mapObject, unsigned int elevation);
+    void _clearHitGrid();
+    void _addDrawnObject(Game::Object* object);
+    /**
+     * Passes mouse event to objects under cursor front to back, then to objects still interacting with mouse.
+     */
+    void _handleObjects(Event::Mouse* event);
+    /**
+     * Redraws parts of pick buffer changed since it was used last time.
+     */
+    void _updatePickBuffer();
+    Game::Object* _pickObject(const Point& position);
+
 };
 
 }
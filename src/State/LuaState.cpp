@@ -21,6 +21,7 @@
 #include <iostream>
 
 // Falltergeist includes
+#include "../Game/Clock.h"
 #include "../Game/Game.h"
 #include "../Lua/Script.h"
 #include "../State/LuaState.h"
@@ -58,6 +59,12 @@ void LuaState::init()
     }
 }
 
+unsigned int LuaState::nextWakeUp()
+{
+    // Script may change anything on any step
+    return Game::getInstance()->clock()->ticks();
+}
+
 void LuaState::think()
 {
     State::think();
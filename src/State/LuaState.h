@@ -56,6 +56,7 @@ public:
 
     void init() override;
     void think() override;
+    unsigned int nextWakeUp() override;
     void handle(Event::Event* event) override;
     void render() override;
 
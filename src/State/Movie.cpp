@@ -28,6 +28,7 @@
 #include "../Event/Keyboard.h"
 #include "../Event/Mouse.h"
 #include "../Game/Game.h"
+#include "../Graphics/RenderCache.h"
 #include "../Graphics/Renderer.h"
 #include "../Ini/File.h"
 #include "../Ini/Parser.h"
@@ -47,6 +48,8 @@ namespace State
 Movie::Movie(int id) : State()
 {
     _id = id;
+    // Every frame is different
+    _renderCache.reset();
 }
 
 Movie::~Movie()
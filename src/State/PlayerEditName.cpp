@@ -18,10 +18,12 @@
  */
 
 // C++ standard includes
+#include <algorithm>
 #include <ctype.h>
 
 // Falltergeist includes
 #include "../functions.h"
+#include "../Game/Clock.h"
 #include "../Game/Game.h"
 #include "../Graphics/Renderer.h"
 #include "../Graphics/Texture.h"
@@ -96,7 +98,7 @@ void PlayerEditName::init()
     _keyCodes.insert(std::make_pair(SDLK_9, '9'));
     _keyCodes.insert(std::make_pair(SDLK_0, '0'));
 
-    _timer = SDL_GetTicks();
+    _timer = Game::getInstance()->clock()->ticks();
 
     auto bg = new UI::Image("art/intrface/charwin.frm");
     bg->setPosition(bgPos + Point(22, 0));
@@ -186,14 +188,20 @@ void PlayerEditName::onDoneButtonClick(Event::Mouse* event)
     doDone();
 }
 
+unsigned int PlayerEditName::nextWakeUp()
+{
+    // Cursor blinks every 300 ms
+    return std::min(State::nextWakeUp(), _timer + 301);
+}
+
 void PlayerEditName::think()
 {
     int bgX = (Game::getInstance()->renderer()->width() - 640) / 2;
     State::think();
-    if (SDL_GetTicks() - _timer > 300)
+    if (Game::getInstance()->clock()->ticks() - _timer > 300)
     {
         _cursor->setVisible(!_cursor->visible());
-        _timer = SDL_GetTicks();
+        _timer = Game::getInstance()->clock()->ticks();
     }
 
     _cursor->setPosition({bgX + _name->textSize().width() + 45, _cursor->position().y()});
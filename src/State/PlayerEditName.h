@@ -47,6 +47,7 @@ public:
 
     void init() override;
     void think() override;
+    unsigned int nextWakeUp() override;
 
     void onDoneButtonClick(Event::Mouse* event);
     void onTextAreaKeyDown(Event::Keyboard* event);
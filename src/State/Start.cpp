@@ -18,12 +18,14 @@
  */
 
 // C++ standard includes
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <ctime>
 
 // Falltergeist includes
 #include "../Base/StlFeatures.h"
+#include "../Game/Clock.h"
 #include "../Game/Game.h"
 #include "../Graphics/Renderer.h"
 #include "../Input/Mouse.h"
@@ -71,11 +73,20 @@ void Start::init()
     srand(time(NULL)); // seed
     addUI("splash", new UI::Image("art/splash/" + splashes.at(rand() % splashes.size())));
 
-    _splashTicks = SDL_GetTicks();
+    _splashTicks = Game::getInstance()->clock()->ticks();
 
     Game::getInstance()->mouse()->setState(Input::Mouse::Cursor::WAIT);
 }
 
+unsigned int Start::nextWakeUp()
+{
+    if (Game::getInstance()->settings()->forceLocation())
+    {
+        return Game::getInstance()->clock()->ticks();
+    }
+    return std::min(State::nextWakeUp(), _splashTicks + 3001);
+}
+
 void Start::think()
 {
     auto game = Game::getInstance();
@@ -88,7 +99,7 @@ void Start::think()
         game->setState(new Location());
         return;
     }
-    if (_splashTicks + 3000 < SDL_GetTicks())
+    if (_splashTicks + 3000 < game->clock()->ticks())
     {
         game->setState(new MainMenu());
         game->pushState(new Movie(17));
@@ -40,6 +40,7 @@ public:
     Start();
     virtual ~Start();
     virtual void think();
+    unsigned int nextWakeUp() override;
     virtual void init();
 };
 
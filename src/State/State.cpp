@@ -26,7 +26,9 @@
 // Falltergeist includes
 #include "../Base/StlFeatures.h"
 #include "../Event/State.h"
+#include "../Game/Clock.h"
 #include "../Game/Game.h"
+#include "../Graphics/RenderCache.h"
 #include "../Graphics/Renderer.h"
 #include "../UI/ImageList.h"
 #include "../UI/SmallCounter.h"
@@ -43,6 +45,7 @@ using namespace Base;
 
 State::State() : Event::EventTarget(Game::getInstance()->eventDispatcher())
 {
+    _renderCache = make_unique<Graphics::RenderCache>();
     addEventHandler("activate",   [this](Event::Event* event){ this->onStateActivate(dynamic_cast<Event::State*>(event)); });
     addEventHandler("deactivate", [this](Event::Event* event){ this->onStateDeactivate(dynamic_cast<Event::State*>(event)); });
 }
@@ -66,6 +69,16 @@ void State::think()
     }
 }
 
+unsigned int State::nextWakeUp()
+{
+    unsigned int wakeUp = Game::Clock::NEVER;
+    for (auto& ui : _ui)
+    {
+        wakeUp = std::min(wakeUp, ui->nextWakeUp());
+    }
+    return wakeUp;
+}
+
 int State::x() const
 {
     return _position.x();
@@ -186,6 +199,8 @@ void State::handle(Event::Event* event)
 
 void State::render()
 {
+    auto renderer = Game::getInstance()->renderer();
+    if (_renderCache) renderer->beginCache(_renderCache.get());
     for (auto& ui : _ui)
     {
         if (ui->visible())
@@ -193,9 +208,29 @@ void State::render()
             ui->render(false);
         }
     }
+    if (_renderCache) renderer->endCache();
     _uiToDelete.clear();
 }
 
+void State::renderSnapshot()
+{
+    auto renderer = Game::getInstance()->renderer();
+    if (!_snapshot)
+    {
+        _snapshot = make_unique<Graphics::RenderCache>();
+    }
+    if (renderer->drawCache(_snapshot.get())) return;
+
+    renderer->beginCache(_snapshot.get());
+    render();
+    renderer->endCache();
+}
+
+void State::invalidateSnapshot()
+{
+    if (_snapshot) _snapshot->invalidate();
+}
+
 void State::popUI()
 {
     if (_ui.size() == 0) return;
@@ -223,6 +258,11 @@ bool State::active()
 void State::setActive(bool value)
 {
     _active = value;
+    // Active state is rendered as usual, its snapshot would be outdated soon
+    if (_active)
+    {
+        _snapshot.reset();
+    }
 }
 
 }
@@ -44,6 +44,10 @@ namespace Game
 {
     class Game;
 }
+namespace Graphics
+{
+    class RenderCache;
+}
 namespace UI
 {
     class ImageList;
@@ -105,11 +109,23 @@ public:
      * This method is called after handle() but before render() in the main loop.
      */
     virtual void think();
+    /**
+     * Simulation time when the state changes by itself next, Game::Clock::NEVER if it changes on input only.
+     * By default the earliest wake-up of its UI elements.
+     */
+    virtual unsigned int nextWakeUp();
     /**
      * @brief Renders all visible objects of this state on screen.
+     * UI is composed into a cache, so unchanged UI costs a single draw call.
      * This method is called last in the main loop (after handle() and think()).
      */
     virtual void render();
+    /**
+     * Renders inactive state, which is frozen under a modal one. It is rendered once into a snapshot,
+     * the snapshot is reused until the state is active again or invalidateSnapshot() is called.
+     */
+    void renderSnapshot();
+    void invalidateSnapshot();
 
     virtual void onStateActivate(Event::State* event);
     virtual void onStateDeactivate(Event::State* event);
@@ -128,6 +144,11 @@ protected:
     bool _fullscreen = true; // prevents render all states before this one
     bool _initialized = false;
 
+    // Composed UI, nullptr for states that change every frame
+    std::unique_ptr<Graphics::RenderCache> _renderCache;
+    // Whole state while it is inactive
+    std::unique_ptr<Graphics::RenderCache> _snapshot;
+
 };
 
 }
@@ -106,6 +106,8 @@ void WorldMap::init()
         mapMinY = (renderHeight - 480)/2 + 21;
     }
     _screenMap = new UI::Image (mapWidth, mapHeight);
+    // Viewport is redrawn from map tiles every frame
+    _screenMap->texture()->setStreaming(true);
     _screenMap->setPosition(Point(mapMinX, mapMinY));
 }
 
@@ -31,6 +31,10 @@
 
 namespace Falltergeist
 {
+namespace Graphics
+{
+    class PaletteOverlay;
+}
 namespace UI
 {
 
@@ -40,15 +44,12 @@ public:
     AnimatedImage(libfalltergeist::Frm::File* frm, unsigned int direction);
     ~AnimatedImage() override;
 
+    unsigned int nextWakeUp() const override;
     void render(bool eggTransparency = false) override;
 
 protected:
-    std::vector<Graphics::Texture*> _slimeTextures;
-    std::vector<Graphics::Texture*> _fireSlowTextures;
-    std::vector<Graphics::Texture*> _fireFastTextures;
-    std::vector<Graphics::Texture*> _shoreTextures;
-    std::vector<Graphics::Texture*> _monitorTextures;
-    std::vector<Graphics::Texture*> _reddotTextures;
+    // Shared with other images of the same FRM
+    Graphics::PaletteOverlay* _overlay = nullptr;
 };
 
 }
@@ -21,18 +21,16 @@
 #include "../UI/Animation.h"
 
 // C++ standard includes
+#include <algorithm>
 #include <cmath>
 
 // Falltergeist includes
 #include "../Base/StlFeatures.h"
-#include "../Game/DudeObject.h"
+#include "../Game/Clock.h"
 #include "../Game/Game.h"
 #include "../Graphics/AnimatedPalette.h"
-#include "../Graphics/Renderer.h"
 #include "../Graphics/Texture.h"
-#include "../LocationCamera.h"
 #include "../ResourceManager.h"
-#include "../State/Location.h"
 #include "../UI/AnimationFrame.h"
 
 // Third party includes
@@ -102,116 +100,7 @@ Animation::Animation(const std::string& frmName, unsigned int direction) : Fallt
 
     if (frm->animatedPalette())
     {
-        Graphics::AnimatedPalette*  palette=Game::getInstance()->animatedPalette();
-        auto masks = frm->animatedMasks();
-
-        if ((*masks)[MASK::MONITOR] != NULL)
-        {
-            for (auto i=0; i<5; i++)
-            {
-                unsigned int mask[frm->width() * frm->height()];
-
-                //modify
-                for (unsigned int j = 0; j< frm->width() * frm->height(); j++)
-                {
-                    mask[j] = palette->color((*masks)[MASK::MONITOR][j], i);
-                }
-                //set
-                auto texture = new Graphics::Texture(frm->width(), frm->height());
-                texture->loadFromRGBA(mask);
-                _monitorTextures.push_back(texture);
-            }
-        }
-
-        if ((*masks)[MASK::SLIME] != NULL)
-        {
-            for (auto i=0; i<4; i++)
-            {
-                unsigned int mask[frm->width() * frm->height()];
-
-                //modify
-                for (unsigned int j = 0; j< frm->width() * frm->height(); j++)
-                {
-                    mask[j] = palette->color(((*masks)[MASK::SLIME][j]), i);
-                }
-                //set
-                auto texture = new Graphics::Texture(frm->width(), frm->height());
-                texture->loadFromRGBA(mask);
-                _slimeTextures.push_back(texture);
-            }
-        }
-
-        if ((*masks)[MASK::SHORE] != NULL)
-        {
-            for (auto i=0; i<6; i++)
-            {
-                unsigned int mask[frm->width() * frm->height()];
-
-                //modify
-                for (unsigned int j = 0; j< frm->width() * frm->height(); j++)
-                {
-                    mask[j] = palette->color(((*masks)[MASK::SHORE][j]), i);
-                }
-                //set
-                auto texture = new Graphics::Texture(frm->width(), frm->height());
-                texture->loadFromRGBA(mask);
-                _shoreTextures.push_back(texture);
-            }
-        }
-
-
-        if ((*masks)[MASK::FIRE_SLOW] != NULL)
-        {
-            for (auto i=0; i<5; i++)
-            {
-                unsigned int mask[frm->width() * frm->height()];
-
-                //modify
-                for (unsigned int j = 0; j< frm->width() * frm->height(); j++)
-                {
-                    mask[j] = palette->color(((*masks)[MASK::FIRE_SLOW][j]), i);
-                }
-                //set
-                auto texture = new Graphics::Texture(frm->width(), frm->height());
-                texture->loadFromRGBA(mask);
-                _fireSlowTextures.push_back(texture);
-            }
-        }
-
-
-        if ((*masks)[MASK::FIRE_FAST] != NULL)
-        {
-            for (auto i=0; i<5; i++)
-            {
-                unsigned int mask[frm->width() * frm->height()];
-                //modify
-                for (unsigned int j = 0; j< frm->width() * frm->height(); j++)
-                {
-                    mask[j] = palette->color(((*masks)[MASK::FIRE_FAST][j]), i);
-                }
-                //set
-                auto texture = new Graphics::Texture(frm->width(), frm->height());
-                texture->loadFromRGBA(mask);
-                _fireFastTextures.push_back(texture);
-            }
-        }
-
-        if ((*masks)[MASK::REDDOT] != NULL)
-        {
-            for (auto i=0; i<16; i++)
-            {
-                unsigned int mask[frm->width() * frm->height()];
-                //modify
-                for (unsigned int j = 0; j< frm->width() * frm->height(); j++)
-                {
-                    mask[j] = palette->color(((*masks)[MASK::REDDOT][j]), i);
-                }
-                //set
-                auto texture = new Graphics::Texture(frm->width(), frm->height());
-                texture->loadFromRGBA(mask);
-                _reddotTextures.push_back(texture);
-            }
-        }
+        _overlay = Game::getInstance()->animatedPalette()->overlay(frm);
     }
 }
 
@@ -228,9 +117,10 @@ void Animation::think()
 {
     if (!_playing) return;
 
-    if (SDL_GetTicks() - _frameTicks >= _animationFrames.at(_currentFrame)->duration())
+    _frameTime += Game::getInstance()->clock()->delta();
+    if (_frameTime >= _animationFrames.at(_currentFrame)->duration())
     {
-        _frameTicks = SDL_GetTicks();
+        _frameTime -= _animationFrames.at(_currentFrame)->duration();
 
         _progress += 1;
         if (_progress < _animationFrames.size())
@@ -255,124 +145,7 @@ void Animation::render(bool eggTransparency)
     auto& frame = _animationFrames.at(_currentFrame);
     Point framePos = Point(frame->x(), frame->y());
     Size frameSize = Size(frame->width(), frame->height());
-    Point offsetPosition = position() + offset();
-    Point offsetFramePos = framePos + offset();
-    Graphics::AnimatedPalette* pal = Game::getInstance()->animatedPalette();
-
-    if (eggTransparency)
-    {
-        auto dude = Game::getInstance()->player();
-
-        if (!dude || !Game::getInstance()->locationState())
-        {
-            Game::getInstance()->renderer()->drawTexture(_texture, offsetPosition, framePos, frameSize);
-
-            if (pal->getCounter(MASK::FIRE_FAST) < _fireFastTextures.size())
-                Game::getInstance()->renderer()->drawTexture(_fireFastTextures.at(pal->getCounter(MASK::FIRE_FAST)), position(), framePos, frameSize);
-
-            if (pal->getCounter(MASK::FIRE_SLOW) < _fireSlowTextures.size())
-                Game::getInstance()->renderer()->drawTexture(_fireSlowTextures.at(pal->getCounter(MASK::FIRE_SLOW)), position(), framePos, frameSize);
-
-            if (pal->getCounter(MASK::SLIME) < _slimeTextures.size())
-                Game::getInstance()->renderer()->drawTexture(_slimeTextures.at(pal->getCounter(MASK::SLIME)), position(), framePos, frameSize);
-
-            if (pal->getCounter(MASK::SHORE) < _shoreTextures.size())
-                Game::getInstance()->renderer()->drawTexture(_shoreTextures.at(pal->getCounter(MASK::SHORE)), position(), framePos, frameSize);
-
-            if (pal->getCounter(MASK::MONITOR) < _monitorTextures.size())
-                Game::getInstance()->renderer()->drawTexture(_monitorTextures.at(pal->getCounter(MASK::MONITOR)), position(), framePos, frameSize);
-
-            if (pal->getCounter(MASK::REDDOT) < _reddotTextures.size())
-                Game::getInstance()->renderer()->drawTexture(_reddotTextures.at(pal->getCounter(MASK::REDDOT)), position(), framePos, frameSize);
-
-            return;
-        }
-
-        auto camera = Game::getInstance()->locationState()->camera();
-        Point eggPos = dude->hexagon()->position() - camera->topLeft() - Point(63, 78) + dude->ui()->offset();
-
-        Point eggDelta = position() - eggPos;
-
-        auto egg = ResourceManager::getInstance()->texture("data/egg.png");
-
-        //check if egg and texture intersects
-        SDL_Rect egg_rect = { eggPos.x(), eggPos.y(), (int)egg->width(), (int)egg->height() };
-        SDL_Rect tex_rect = { offsetPosition.x(), offsetPosition.y(), (int)frame->width(), (int)frame->height() };
-
-        if (!SDL_HasIntersection(&egg_rect, &tex_rect))
-        {
-            Game::getInstance()->renderer()->drawTexture(_texture, offsetPosition, framePos, frameSize);
-
-            if (pal->getCounter(MASK::FIRE_FAST) < _fireFastTextures.size())
-                Game::getInstance()->renderer()->drawTexture(_fireFastTextures.at(pal->getCounter(MASK::FIRE_FAST)), offsetPosition, framePos, frameSize);
-
-            if (pal->getCounter(MASK::FIRE_SLOW) < _fireSlowTextures.size())
-                Game::getInstance()->renderer()->drawTexture(_fireSlowTextures.at(pal->getCounter(MASK::FIRE_SLOW)), offsetPosition, framePos, frameSize);
-
-            if (pal->getCounter(MASK::SLIME) < _slimeTextures.size())
-                Game::getInstance()->renderer()->drawTexture(_slimeTextures.at(pal->getCounter(MASK::SLIME)), position(), offsetFramePos, frameSize);
-
-            if (pal->getCounter(MASK::SHORE) < _shoreTextures.size())
-                Game::getInstance()->renderer()->drawTexture(_shoreTextures.at(pal->getCounter(MASK::SHORE)), position(), offsetFramePos, frameSize);
-
-            if (pal->getCounter(MASK::MONITOR) < _monitorTextures.size())
-                Game::getInstance()->renderer()->drawTexture(_monitorTextures.at(pal->getCounter(MASK::MONITOR)), position(), offsetFramePos, frameSize);
-
-            if (pal->getCounter(MASK::REDDOT) < _reddotTextures.size())
-                Game::getInstance()->renderer()->drawTexture(_reddotTextures.at(pal->getCounter(MASK::REDDOT)), position(), offsetFramePos, frameSize);
-
-            return;
-        }
-
-        if (!_tmptex)
-        {
-            _tmptex = make_unique<Graphics::Texture>(texture()->width(),texture()->height());
-        }
-        texture()->copyTo(_tmptex.get());
-
-        if (pal->getCounter(MASK::FIRE_FAST) < _fireFastTextures.size())
-            _fireFastTextures.at(pal->getCounter(MASK::FIRE_FAST))->copyTo(_tmptex.get());
-
-        if (pal->getCounter(MASK::FIRE_SLOW) < _fireSlowTextures.size())
-           _fireSlowTextures.at(pal->getCounter(MASK::FIRE_SLOW))->copyTo(_tmptex.get());
-
-        if (pal->getCounter(MASK::SLIME) < _slimeTextures.size())
-            _slimeTextures.at(pal->getCounter(MASK::SLIME))->copyTo(_tmptex.get());
-
-        if (pal->getCounter(MASK::SHORE) < _shoreTextures.size())
-            _shoreTextures.at(pal->getCounter(MASK::SHORE))->copyTo(_tmptex.get());
-
-        if (pal->getCounter(MASK::MONITOR) < _monitorTextures.size())
-            _monitorTextures.at(pal->getCounter(MASK::MONITOR))->copyTo(_tmptex.get());
-
-        if (pal->getCounter(MASK::REDDOT) < _reddotTextures.size())
-            _reddotTextures.at(pal->getCounter(MASK::REDDOT))->copyTo(_tmptex.get());
-
-        _tmptex->blitWithAlpha(egg, eggDelta.x(), eggDelta.y());
-        Game::getInstance()->renderer()->drawTexture(_tmptex.get(), offsetPosition, framePos, frameSize);
-    }
-    else
-    {
-        Game::getInstance()->renderer()->drawTexture(_texture, offsetPosition, framePos, frameSize);
-
-        if (pal->getCounter(MASK::FIRE_FAST) < _fireFastTextures.size())
-            Game::getInstance()->renderer()->drawTexture(_fireFastTextures.at(pal->getCounter(MASK::FIRE_FAST)), offsetPosition, framePos, frameSize);
-
-        if (pal->getCounter(MASK::FIRE_SLOW) < _fireSlowTextures.size())
-            Game::getInstance()->renderer()->drawTexture(_fireSlowTextures.at(pal->getCounter(MASK::FIRE_SLOW)), offsetPosition, framePos, frameSize);
-
-        if (pal->getCounter(MASK::SLIME) < _slimeTextures.size())
-            Game::getInstance()->renderer()->drawTexture(_slimeTextures.at(pal->getCounter(MASK::SLIME)), offsetPosition, framePos, frameSize);
-
-        if (pal->getCounter(MASK::SHORE) < _shoreTextures.size())
-            Game::getInstance()->renderer()->drawTexture(_shoreTextures.at(pal->getCounter(MASK::SHORE)), offsetPosition, framePos, frameSize);
-
-        if (pal->getCounter(MASK::MONITOR) < _monitorTextures.size())
-            Game::getInstance()->renderer()->drawTexture(_monitorTextures.at(pal->getCounter(MASK::MONITOR)), offsetPosition, framePos, frameSize);
-
-        if (pal->getCounter(MASK::REDDOT) < _reddotTextures.size())
-            Game::getInstance()->renderer()->drawTexture(_reddotTextures.at(pal->getCounter(MASK::REDDOT)), offsetPosition, framePos, frameSize);
-    }
+    _renderTexture(_texture, position() + offset(), framePos, frameSize, _overlay, eggTransparency);
 }
 
 Size Animation::size() const
@@ -409,6 +182,22 @@ unsigned int Animation::pixel(const Point& pos)
     return Base::pixel(offsetPos + Point(frame->x(), frame->y()));
 }
 
+unsigned int Animation::nextWakeUp() const
+{
+    auto game = Game::getInstance();
+    unsigned int wakeUp = Game::Clock::NEVER;
+    if (_playing)
+    {
+        auto duration = _animationFrames.at(_currentFrame)->duration();
+        wakeUp = game->clock()->ticks() + (duration > _frameTime ? duration - _frameTime : 0);
+    }
+    if (_overlay)
+    {
+        wakeUp = std::min(wakeUp, game->animatedPalette()->nextWakeUp());
+    }
+    return wakeUp;
+}
+
 void Animation::play()
 {
     _playing = true;
@@ -419,6 +208,7 @@ void Animation::stop()
     _playing = false;
     _ended = false;
     _progress = 0;
+    _frameTime = 0;
 }
 
 void Animation::setReverse(bool value)
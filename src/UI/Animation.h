@@ -31,6 +31,10 @@
 
 namespace Falltergeist
 {
+namespace Graphics
+{
+    class PaletteOverlay;
+}
 namespace UI
 {
 class AnimationFrame;
@@ -45,6 +49,7 @@ public:
     std::vector<std::unique_ptr<AnimationFrame>>& frames();
 
     void think() override;
+    unsigned int nextWakeUp() const override;
     void render(bool eggTransparency = false) override;
 
     const Point& shift() const;
@@ -77,14 +82,10 @@ protected:
     unsigned int _currentFrame = 0;
     unsigned int _actionFrame = 0;
     unsigned int _progress = 0;
-    unsigned int _frameTicks = 0;
-    std::vector<Graphics::Texture*> _slimeTextures;
-    std::vector<Graphics::Texture*> _fireSlowTextures;
-    std::vector<Graphics::Texture*> _fireFastTextures;
-    std::vector<Graphics::Texture*> _shoreTextures;
-    std::vector<Graphics::Texture*> _monitorTextures;
-    std::vector<Graphics::Texture*> _reddotTextures;
-
+    // Simulation time current frame is shown for
+    unsigned int _frameTime = 0;
+    // Shared with other animations of the same FRM
+    Graphics::PaletteOverlay* _overlay = nullptr;
 };
 
 }
@@ -25,6 +25,8 @@
 // Falltergeist includes
 #include "../Base/StlFeatures.h"
 #include "../Event/Event.h"
+#include "../Game/Clock.h"
+#include "../Game/Game.h"
 #include "../UI/Animation.h"
 
 // Third party includes
@@ -118,6 +120,14 @@ void AnimationQueue::think()
     }
 }
 
+unsigned int AnimationQueue::nextWakeUp() const
+{
+    if (!_playing) return Game::Clock::NEVER;
+    // Next animation in queue is started by think()
+    if (!currentAnimation()->playing()) return Game::getInstance()->clock()->ticks();
+    return currentAnimation()->nextWakeUp();
+}
+
 Graphics::Texture* AnimationQueue::texture() const
 {
     return currentAnimation()->texture();
@@ -52,6 +52,7 @@ public:
     Graphics::Texture* texture() const override;
     void render(bool eggTransparency = false) override;
     void think() override;
+    unsigned int nextWakeUp() const override;
     unsigned int pixel(const Point& pos) override;
 
     Size size() const override;
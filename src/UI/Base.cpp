@@ -25,8 +25,10 @@
 
 // Falltergeist includes
 #include "../Base/StlFeatures.h"
+#include "../Game/Clock.h"
 #include "../Game/Game.h"
 #include "../Game/DudeObject.h"
+#include "../Graphics/PaletteOverlay.h"
 #include "../Graphics/Renderer.h"
 #include "../Graphics/Texture.h"
 #include "../LocationCamera.h"
@@ -89,53 +91,85 @@ void Base::think()
 {
 }
 
+unsigned int Base::nextWakeUp() const
+{
+    return Game::Clock::NEVER;
+}
+
 void Base::render(bool eggTransparency)
 {
+    auto tex = texture();
+    if (!tex) return;
+    _renderTexture(tex, position(), Point(), Size(tex->width(), tex->height()), nullptr, eggTransparency);
+}
+
+void Base::_renderTexture(Graphics::Texture* texture, const Point& position, const Point& source, const Size& size,
+                          Graphics::PaletteOverlay* overlay, bool eggTransparency)
+{
+    auto renderer = Game::getInstance()->renderer();
+    SDL_Rect destination = {position.x(), position.y(), size.width(), size.height()};
+    SDL_Rect masked;
+    Graphics::Texture* egg = nullptr;
+    Point eggPos;
 
+    _eggMasked = false;
     if (eggTransparency)
     {
         auto dude = Game::getInstance()->player();
-
-        if (!dude || !Game::getInstance()->locationState())
+        if (dude && Game::getInstance()->locationState())
         {
-            Game::getInstance()->renderer()->drawTexture(texture(), position());
-            return;
-        }
-
-        auto camera = Game::getInstance()->locationState()->camera();
+            auto camera = Game::getInstance()->locationState()->camera();
+            eggPos = dude->hexagon()->position() - camera->topLeft() - Point(63, 78) + dude->ui()->offset();
+            egg = ResourceManager::getInstance()->texture("data/egg.png");
 
-        Point eggPos = dude->hexagon()->position() - camera->topLeft() - Point(63, 78) + dude->ui()->offset();
-
-        Point eggDelta = position() - eggPos;
-
-        auto egg = ResourceManager::getInstance()->texture("data/egg.png");
-
-        //check if egg and texture intersects
-        SDL_Rect egg_rect = { eggPos.x(), eggPos.y(), (int)egg->width(), (int)egg->height() };
-        SDL_Rect tex_rect = { x(), y(), (int)texture()->width(), (int)texture()->height() };
-
-        if (!SDL_HasIntersection(&egg_rect, &tex_rect))
-        {
-            Game::getInstance()->renderer()->drawTexture(texture(), position());
-            return;
-        }
-
-        if (!_tmptex)
-        {
-            _tmptex = make_unique<Graphics::Texture>(texture()->width(), texture()->height());
+            SDL_Rect eggRect = {eggPos.x(), eggPos.y(), (int)egg->width(), (int)egg->height()};
+            _eggMasked = SDL_IntersectRect(&destination, &eggRect, &masked);
+            _eggOffset = eggPos - position + source;
         }
-        texture()->copyTo(_tmptex.get());
-
-        _tmptex->blitWithAlpha(egg, eggDelta.x(), eggDelta.y());
-        Game::getInstance()->renderer()->drawTexture(_tmptex.get(), position());
     }
-    else
+
+    if (!_eggMasked)
     {
-        Game::getInstance()->renderer()->drawTexture(texture(), position());
+        renderer->drawTexture(texture, position, source, size);
+        if (overlay) overlay->render(position, source, size);
+        return;
     }
 
+    // Parts around the egg are drawn as they are
+    SDL_Rect parts[4] = {
+        {destination.x, destination.y, destination.w, masked.y - destination.y},
+        {destination.x, masked.y + masked.h, destination.w, destination.y + destination.h - masked.y - masked.h},
+        {destination.x, masked.y, masked.x - destination.x, masked.h},
+        {masked.x + masked.w, masked.y, destination.x + destination.w - masked.x - masked.w, masked.h}
+    };
+    for (auto& part : parts)
+    {
+        if (part.w <= 0 || part.h <= 0) continue;
+
+        Point partSource = source + Point(part.x - destination.x, part.y - destination.y);
+        renderer->drawTexture(texture, Point(part.x, part.y), partSource, Size(part.w, part.h));
+        if (overlay) overlay->render(Point(part.x, part.y), partSource, Size(part.w, part.h));
+    }
 
+    // Scratch texture is as big as the egg, so it is created once and reused every frame
+    if (!_tmptex || _tmptex->width() < egg->width() || _tmptex->height() < egg->height())
+    {
+        _tmptex = make_unique<Graphics::Texture>(egg->width(), egg->height());
+        _tmptex->setStreaming(true);
+    }
 
+    Point maskedSource = source + Point(masked.x - destination.x, masked.y - destination.y);
+    Point maskPos = Point(masked.x, masked.y) - eggPos;
+    SDL_Rect sourceRect = {maskedSource.x(), maskedSource.y(), masked.w, masked.h};
+    _tmptex->copyMasked(texture, sourceRect, egg, maskPos.x(), maskPos.y());
+    if (overlay)
+    {
+        // Overlay pixels are opaque, so masking the result once more equals masking texture with overlay drawn over it
+        overlay->copyTo(_tmptex.get(), maskedSource);
+        SDL_Rect scratchRect = {0, 0, masked.w, masked.h};
+        _tmptex->copyMasked(_tmptex.get(), scratchRect, egg, maskPos.x(), maskPos.y());
+    }
+    renderer->drawTexture(_tmptex.get(), Point(masked.x, masked.y), Point(), Size(masked.w, masked.h));
 }
 
 void Base::setVisible(bool value)
@@ -182,12 +216,21 @@ Size Base::size() const
 
 unsigned int Base::pixel(const Point& pos)
 {
-    if (_tmptex)
+    auto tex = texture();
+    if (!tex) return 0;
+
+    unsigned int pixel = tex->pixel((unsigned)pos.x(), (unsigned)pos.y());
+    if (_eggMasked)
     {
-        return _tmptex->pixel((unsigned)pos.x(), (unsigned)pos.y()) & 0xFF; // return only alpha channel
+        // Same masking as in _renderTexture(), without keeping masked copy of the whole texture
+        auto egg = ResourceManager::getInstance()->texture("data/egg.png");
+        Point eggPos = pos - _eggOffset;
+        if (Rect::inRect(eggPos, Size(egg->width(), egg->height())))
+        {
+            return pixel & egg->pixel((unsigned)eggPos.x(), (unsigned)eggPos.y()) & 0xFF; // return only alpha channel
+        }
     }
-    auto tex = texture();
-    return tex ? tex->pixel((unsigned)pos.x(), (unsigned)pos.y()) : 0;
+    return pixel;
 }
 
 unsigned int Base::pixel(unsigned int x, unsigned int y)
@@ -195,6 +238,11 @@ unsigned int Base::pixel(unsigned int x, unsigned int y)
     return pixel(Point(x, y));
 }
 
+bool Base::interacting() const
+{
+    return _hovered || _leftButtonPressed || _rightButtonPressed || _drag;
+}
+
 void Base::handle(Event::Event* event)
 {
     if (event->handled()) return;
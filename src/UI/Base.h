@@ -33,6 +33,7 @@ namespace Falltergeist
 {
 namespace Graphics
 {
+    class PaletteOverlay;
     class Texture;
 }
 
@@ -82,6 +83,11 @@ public:
      * This method is called after handle() but before render() in the main loop.
      */
     virtual void think();
+    /**
+     * Simulation time when the element changes by itself next, Game::Clock::NEVER if it changes on input only.
+     * The main loop sleeps until the earliest wake-up when nothing happens.
+     */
+    virtual unsigned int nextWakeUp() const;
     /**
      * @brief Render this UI element on game window.
      * This method is called last in the main loop (after handle() and think()).
@@ -93,6 +99,11 @@ public:
     virtual unsigned int pixel(const Point& pos);
     unsigned int pixel(unsigned int x, unsigned int y);
 
+    /**
+     * Whether element is hovered, pressed or dragged, so it needs mouse events even when cursor is not over it.
+     */
+    bool interacting() const;
+
 protected:
     Point _position;
     Point _offset;
@@ -101,9 +112,20 @@ protected:
      * Generate and set new blank texture with given size
      */
     void _generateTexture(unsigned int width, unsigned int height);
+    /**
+     * Draws rectangle of texture with its palette overlay at given position.
+     * With egg transparency, pixels under the egg around the player are masked by it,
+     * the rest of the rectangle is drawn as is.
+     */
+    void _renderTexture(Graphics::Texture* texture, const Point& position, const Point& source, const Size& size,
+                        Graphics::PaletteOverlay* overlay, bool eggTransparency);
 
     Graphics::Texture* _texture = nullptr;
+    // Masked part of the texture under the egg
     std::unique_ptr<Graphics::Texture> _tmptex;
+    // Whether the egg covered the texture when it was drawn last time, and texture point under egg top left corner
+    bool _eggMasked = false;
+    Point _eggOffset;
     bool _leftButtonPressed = false;
     bool _rightButtonPressed = false;
     bool _drag = false;
@@ -24,6 +24,7 @@
 #include <bitset>
 
 // Falltergeist includes
+#include "../Game/Clock.h"
 #include "../Game/Game.h"
 #include "../Graphics/Renderer.h"
 #include "../Exception.h"
@@ -747,6 +748,7 @@ void MvePlayer::_initVideoBuffer(uint8_t* data)
 
     if (_texture != nullptr) return;
     _generateTexture(width, height);
+    _texture->setStreaming(true);
 }
 
 
@@ -919,6 +921,12 @@ void MvePlayer::think()
     }
 }
 
+unsigned int MvePlayer::nextWakeUp() const
+{
+    // Chunks are timed by the movie itself
+    return _finished ? Game::Clock::NEVER : Game::getInstance()->clock()->ticks();
+}
+
 bool MvePlayer::finished()
 {
     return _finished;
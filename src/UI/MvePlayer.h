@@ -42,6 +42,7 @@ public:
     ~MvePlayer() override;
 
     void think() override;
+    unsigned int nextWakeUp() const override;
     void render(bool eggTransparency = false) override;
     bool finished();
     uint32_t getAudio(uint8_t* data, uint32_t len);
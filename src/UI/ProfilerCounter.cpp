@@ -0,0 +1,87 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Related headers
+#include "../UI/ProfilerCounter.h"
+
+// C++ standard includes
+#include <iomanip>
+#include <sstream>
+
+// Falltergeist includes
+#include "../Game/Clock.h"
+#include "../Game/Game.h"
+#include "../Profiler.h"
+
+// Third party includes
+#include "SDL.h"
+
+namespace Falltergeist
+{
+namespace UI
+{
+
+ProfilerCounter::ProfilerCounter(const Point& pos) : TextArea(pos)
+{
+    setWidth(240);
+    _update();
+}
+
+ProfilerCounter::ProfilerCounter(int x, int y) : ProfilerCounter(Point(x, y))
+{
+}
+
+ProfilerCounter::~ProfilerCounter()
+{
+}
+
+void ProfilerCounter::think()
+{
+    if (_lastTicks + 500 > SDL_GetTicks()) return;
+    auto previous = text();
+    _update();
+    if (text() != previous)
+    {
+        Game::getInstance()->invalidate();
+    }
+}
+
+unsigned int ProfilerCounter::nextWakeUp() const
+{
+    auto ticks = SDL_GetTicks();
+    return Game::getInstance()->clock()->ticks() + (_lastTicks + 500 > ticks ? _lastTicks + 500 - ticks : 0);
+}
+
+void ProfilerCounter::_update()
+{
+    _lastTicks = SDL_GetTicks();
+
+    // section: average/maximum ms per frame
+    std::stringstream text;
+    text << std::fixed << std::setprecision(2);
+    for (auto& section : Profiler::summary())
+    {
+        text << section.first << ": " << section.second.average / 1000000.0
+             << "/" << section.second.maximum / 1000000.0 << "ms\n";
+    }
+    setText(text.str());
+}
+
+}
+}
@@ -17,52 +17,43 @@
  * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#ifndef FALLTERGEIST_TEXTSYMBOL_H
-#define FALLTERGEIST_TEXTSYMBOL_H
+#ifndef FALLTERGEIST_UI_PROFILERCOUNTER_H
+#define FALLTERGEIST_UI_PROFILERCOUNTER_H
 
 // C++ standard includes
-#include <cstdint>
-#include <memory>
 
 // Falltergeist includes
+#include "../UI/TextArea.h"
 
 // Third party includes
 
 namespace Falltergeist
 {
-
-class Font;
-
-class TextSymbol
+namespace UI
 {
-protected:
-    uint8_t _chr;
-
-    int32_t _x = 0;
-    int32_t _y = 0;
-
-    Font* _font;
 
+/**
+ * Shows Profiler sections with their average and maximum time per frame over the last frames.
+ */
+class ProfilerCounter : public TextArea
+{
 public:
-    TextSymbol(const uint8_t chr, int32_t x = 0, int32_t y = 0);
-    TextSymbol(const TextSymbol& other);
+    ProfilerCounter(const Point& pos = Point());
+    ProfilerCounter(int x, int y);
+    ~ProfilerCounter() override;
 
-    virtual ~TextSymbol();
+    void think() override;
+    /**
+     * Sections are updated every 500 ms of real time.
+     */
+    unsigned int nextWakeUp() const override;
 
-    Font* font() const;
-    void setFont(Font* font);
-
-    int32_t x() const;
-    void setX(int32_t x);
-
-    int32_t y() const;
-    void setY(int32_t y);
-
-    void render(int32_t offsetX = 0, int32_t offsetY = 0);
-
-    uint8_t chr() const;
+protected:
+    unsigned int _lastTicks = 0;
 
+    void _update();
 };
 
 }
-#endif // FALLTERGEIST_TEXTSYMBOL_H
+}
+#endif // FALLTERGEIST_UI_PROFILERCOUNTER_H
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Related headers
+#include "../UI/ResourceCounter.h"
+
+// C++ standard includes
+#include <sstream>
+
+// Falltergeist includes
+#include "../Game/Clock.h"
+#include "../Game/Game.h"
+#include "../ResourceManager.h"
+
+// Third party includes
+#include "SDL.h"
+
+namespace Falltergeist
+{
+namespace UI
+{
+
+ResourceCounter::ResourceCounter(const Point& pos) : TextArea(pos)
+{
+    setWidth(200);
+    setHorizontalAlign(TextArea::HorizontalAlign::RIGHT);
+    _update();
+}
+
+ResourceCounter::ResourceCounter(int x, int y) : ResourceCounter(Point(x, y))
+{
+}
+
+ResourceCounter::~ResourceCounter()
+{
+}
+
+void ResourceCounter::think()
+{
+    if (_lastTicks + 1000 > SDL_GetTicks()) return;
+    auto previous = text();
+    _update();
+    if (text() != previous)
+    {
+        Game::getInstance()->invalidate();
+    }
+}
+
+unsigned int ResourceCounter::nextWakeUp() const
+{
+    auto ticks = SDL_GetTicks();
+    return Game::getInstance()->clock()->ticks() + (_lastTicks + 1000 > ticks ? _lastTicks + 1000 - ticks : 0);
+}
+
+void ResourceCounter::_update()
+{
+    _lastTicks = SDL_GetTicks();
+
+    // type: loaded/cached, resident KB, decode ms
+    std::stringstream text;
+    for (auto& counters : ResourceManager::getInstance()->statistics()->counters())
+    {
+        auto& value = counters.second;
+        text << counters.first << ": " << value.misses << "/" << value.hits
+             << " " << value.residentSize / 1024 << "K"
+             << " " << value.decodeTime / 1000 << "ms\n";
+    }
+    setText(text.str());
+}
+
+}
+}
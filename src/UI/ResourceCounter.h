@@ -0,0 +1,59 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FALLTERGEIST_UI_RESOURCECOUNTER_H
+#define FALLTERGEIST_UI_RESOURCECOUNTER_H
+
+// C++ standard includes
+
+// Falltergeist includes
+#include "../UI/TextArea.h"
+
+// Third party includes
+
+namespace Falltergeist
+{
+namespace UI
+{
+
+/**
+ * Shows ResourceManager statistics per resource type: loaded / cached count, resident size and decode time.
+ */
+class ResourceCounter : public TextArea
+{
+public:
+    ResourceCounter(const Point& pos = Point());
+    ResourceCounter(int x, int y);
+    ~ResourceCounter() override;
+
+    void think() override;
+    /**
+     * Statistics are updated every second of real time.
+     */
+    unsigned int nextWakeUp() const override;
+
+protected:
+    unsigned int _lastTicks = 0;
+
+    void _update();
+};
+
+}
+}
+#endif // FALLTERGEIST_UI_RESOURCECOUNTER_H
@@ -25,15 +25,16 @@
 #include <sstream>
 
 // Falltergeist includes
+#include "../Base/StlFeatures.h"
 #include "../CrossPlatform.h"
 #include "../Event/Mouse.h"
 #include "../Font.h"
 #include "../FontString.h"
+#include "../Game/Clock.h"
 #include "../Game/Game.h"
 #include "../Graphics/Renderer.h"
 #include "../Graphics/Texture.h"
 #include "../ResourceManager.h"
-#include "../UI/TextSymbol.h"
 
 // Third party includes
 #include <SDL.h>
@@ -44,9 +45,11 @@ namespace Falltergeist
 namespace UI
 {
 
+using namespace Base;
+
 TextArea::TextArea(const Point& pos) : Base(pos)
 {
-    _timestampCreated = SDL_GetTicks();
+    _timestampCreated = Game::getInstance()->clock()->ticks();
 }
 
 TextArea::TextArea(int x, int y) : TextArea(Point(x, y))
@@ -55,7 +58,7 @@ TextArea::TextArea(int x, int y) : TextArea(Point(x, y))
 
 TextArea::TextArea(const std::string& text, const Point& pos) : Base(pos)
 {
-    _timestampCreated = SDL_GetTicks();
+    _timestampCreated = Game::getInstance()->clock()->ticks();
     setText(text);
 }
 
@@ -81,8 +84,8 @@ TextArea::~TextArea()
 
 void TextArea::appendText(const std::string& text)
 {
+    _invalidate(_text.length());
     _text += text;
-    _changed = true;
 }
 
 TextArea::HorizontalAlign TextArea::horizontalAlign() const
@@ -94,7 +97,7 @@ void TextArea::setHorizontalAlign(HorizontalAlign align)
 {
     if (_horizontalAlign == align) return;
     _horizontalAlign = align;
-    _changed = true;
+    _textTextureChanged = true;
 }
 
 TextArea::VerticalAlign TextArea::verticalAlign() const
@@ -106,13 +109,16 @@ void TextArea::setVerticalAlign(VerticalAlign align)
 {
     if (_verticalAlign == align) return;
     _verticalAlign = align;
-    _changed = true;
+    _textTextureChanged = true;
 }
 
 void TextArea::setText(const std::string& text)
 {
+    // Common beginning keeps its layout
+    auto mismatch = std::mismatch(_text.begin(), _text.begin() + std::min(_text.length(), text.length()), text.begin());
+    if (mismatch.first == _text.end() && _text.length() == text.length()) return;
+    _invalidate(mismatch.first - _text.begin());
     _text = text;
-    _changed = true;
 }
 
 Font* TextArea::font()
@@ -126,8 +132,9 @@ Font* TextArea::font()
 
 void TextArea::setFont(Font* font)
 {
+    if (_font == font) return;
     _font = font;
-    _changed = true;
+    _invalidate();
 }
 
 void TextArea::setFont(const std::string& fontName, unsigned int color)
@@ -144,7 +151,7 @@ void TextArea::setWordWrap(bool wordWrap)
 {
     if (_wordWrap == wordWrap) return;
     _wordWrap = wordWrap;
-    _changed = true;
+    _invalidate();
 }
 
 bool TextArea::wordWrap() const
@@ -154,7 +161,7 @@ bool TextArea::wordWrap() const
 
 void TextArea::setOutline(bool outline)
 {
-    _outlineColor = outline ? 0x000000ff : 0;
+    setOutlineColor(outline ? 0x000000ff : 0);
 }
 
 bool TextArea::outline() const
@@ -164,7 +171,9 @@ bool TextArea::outline() const
 
 void TextArea::setOutlineColor(unsigned int color)
 {
+    if (_outlineColor == color) return;
     _outlineColor = color;
+    _textTextureChanged = true;
 }
 
 unsigned int TextArea::outlineColor() const
@@ -190,7 +199,7 @@ void TextArea::setSize(const Size& size)
 {
     if (_size == size) return;
     _size = size;
-    _changed = true;
+    _invalidate();
 }
 
 void TextArea::setWidth(int width)
@@ -198,150 +207,235 @@ void TextArea::setWidth(int width)
     setSize({width, _size.height()});
 }
 
+void TextArea::_invalidate(unsigned int position)
+{
+    _changedFrom = _changed ? std::min(_changedFrom, position) : position;
+    _changed = true;
+}
+
 void TextArea::_calculate()
 {
     if (!_changed) return;
-
-    _symbols.clear();
+    _changed = false;
+    _textTextureChanged = true;
 
     if (_text.empty())
     {
-        _changed = false;
+        _glyphs.clear();
+        _lines.clear();
+        _words.clear();
+        _calculatedSize = Size();
         return;
     }
 
-    unsigned x = 0, wordWidth = 0;
-    unsigned y = 0;
-
-    std::vector<std::vector<TextSymbol>> lines = {std::vector<TextSymbol>()};
-    std::vector<unsigned> widths = {0};
-
-    // Parsing lines of text
-    // Cutting lines when it is needed (\n or when exceeding _width)
-    std::istringstream istream(_text);
-    std::string word;
     auto aFont = font();
     auto glyphs = aFont->aaf()->glyphs();
-    while (istream >> word)
+    unsigned int lineHeight = aFont->height() + aFont->verticalGap();
+    bool wrap = _wordWrap && _size.width();
+    unsigned int maxWidth = _size.width();
+
+    // Words before the one with first changed character keep their layout
+    auto word = std::upper_bound(_words.begin(), _words.end(), _changedFrom, [](unsigned int position, const Word& word)
+    {
+        return position < word.position;
+    });
+    unsigned int position = 0;
+    unsigned int x = 0;
+    if (word != _words.begin())
+    {
+        --word;
+        auto resumed = *word;
+        _words.erase(word, _words.end());
+        _glyphs.resize(resumed.firstGlyph);
+        _lines.resize(resumed.line + 1);
+        _lines.back().width = resumed.lineWidth;
+        position = resumed.position;
+        x = resumed.x;
+    }
+    else
     {
-        // calculate word width
-        wordWidth = 0;
-        for (unsigned char ch : word)
+        _words.clear();
+        _glyphs.clear();
+        _lines.assign(1, Line{0, 0});
+        // Leading whitespace is skipped
+        while (position < _text.length() && isspace((unsigned char)_text[position])) ++position;
+    }
+    unsigned int y = (_lines.size() - 1) * lineHeight;
+
+    auto newLine = [&]()
+    {
+        _lines.back().width = x;
+        x = 0;
+        y += lineHeight;
+        _lines.push_back(Line{(unsigned int)_glyphs.size(), 0});
+    };
+
+    // Cutting lines when it is needed (\n or when exceeding width)
+    while (position < _text.length())
+    {
+        _words.push_back(Word{position, x, _lines.back().width, (unsigned int)_lines.size() - 1, (unsigned int)_glyphs.size()});
+
+        // word is followed by its whitespaces
+        unsigned int wordEnd = position;
+        unsigned int wordWidth = 0;
+        while (wordEnd < _text.length() && !isspace((unsigned char)_text[wordEnd]))
         {
-            wordWidth += glyphs->at(ch)->width() + aFont->horizontalGap();
+            wordWidth += glyphs->at((unsigned char)_text[wordEnd])->width() + aFont->horizontalGap();
+            ++wordEnd;
         }
+        unsigned int end = wordEnd;
+        while (end < _text.length() && isspace((unsigned char)_text[end])) ++end;
+
         // switch to next line if word is too long
-        if (_wordWrap && _size.width() && (x + wordWidth) > (unsigned)_size.width())
-        {
-            word = '\n' + word;
-        }
-        // include whitespaces
-        while (!istream.eof() && isspace((int)istream.peek()))
+        if (wrap && (x + wordWidth) > maxWidth)
         {
-            word.push_back((char)istream.get());
+            newLine();
         }
-        // place the word
-        for (unsigned char ch : word)
+
+        for (; position != end; ++position)
         {
+            unsigned char ch = _text[position];
             if (ch == ' ')
             {
                 x += aFont->aaf()->spaceWidth() + aFont->horizontalGap();
             }
 
-            if (ch == '\n' || (_wordWrap && _size.width() && x >= (unsigned)_size.width()))
+            if (ch == '\n' || (wrap && x >= maxWidth))
             {
-                widths.back() = x;
-                x = 0;
-                y += aFont->height() + aFont->verticalGap();
-                lines.emplace_back();
-                widths.push_back(0);
+                newLine();
             }
 
             if (ch == ' ' || ch == '\n')
                 continue;
 
-            TextSymbol symbol(ch, x, y);
-            symbol.setFont(aFont);
-            lines.back().push_back(symbol);
-
+            _glyphs.push_back(Glyph{(int32_t)x, (int32_t)y, ch});
             x += glyphs->at(ch)->width() + aFont->horizontalGap();
-            widths.back() = x;
+            _lines.back().width = x;
         }
     }
 
-    // Calculating textarea sizes if needed
-    _calculatedSize.setWidth(*std::max_element(widths.begin(), widths.end()));
-    _calculatedSize.setHeight(lines.size()*font()->height() + (lines.size() - 1)*font()->verticalGap());
+    unsigned int width = 0;
+    for (auto& line : _lines)
+    {
+        width = std::max(width, line.width);
+    }
+    _calculatedSize.setWidth(width);
+    _calculatedSize.setHeight(_lines.size()*aFont->height() + (_lines.size() - 1)*aFont->verticalGap());
+}
 
-    // Align
+std::string TextArea::text() const
+{
+    return _text;
+}
+
+unsigned int TextArea::timestampCreated() const
+{
+    return _timestampCreated;
+}
+
+void TextArea::_generateTextTexture()
+{
+    _textTextureChanged = false;
+    if (_glyphs.empty()) return;
+
+    auto aFont = font();
     auto outlineFont = (_outlineColor != 0)
                        ? ResourceManager::getInstance()->font(aFont->filename(), _outlineColor)
                        : nullptr;
+    int outline = outlineFont ? 1 : 0;
 
-    for (unsigned i = 0; i != lines.size(); ++i)
+    // Align
+    std::vector<int> offsets;
+    for (auto& line : _lines)
     {
-        auto& line = lines.at(i);
-
-        unsigned xOffset = 0;
-        unsigned yOffset = 0;
-
+        int xOffset = 0;
         if (_horizontalAlign != HorizontalAlign::LEFT)
         {
-            xOffset = (_size.width() ? _size.width() : _calculatedSize.width()) - widths.at(i);
+            xOffset = (_size.width() ? _size.width() : _calculatedSize.width()) - (int)line.width;
             if (_horizontalAlign == HorizontalAlign::CENTER)
             {
                 xOffset = xOffset / 2;
             }
         }
+        offsets.push_back(xOffset);
+    }
+
+    int left = 0;
+    int right = 0;
+    for (unsigned int i = 0; i != _lines.size(); ++i)
+    {
+        unsigned int end = i + 1 < _lines.size() ? _lines.at(i + 1).firstGlyph : _glyphs.size();
+        if (_lines.at(i).firstGlyph == end) continue;
+        left = std::min(left, _glyphs.at(_lines.at(i).firstGlyph).x + offsets.at(i));
+        right = std::max(right, _glyphs.at(end - 1).x + offsets.at(i) + aFont->width());
+    }
+    left -= outline;
+    right += outline;
+    int top = -outline;
+    int bottom = _glyphs.back().y + aFont->height() + outline;
+    _textTextureOffset = Point(left, top);
+    _textTextureSize = Size(right - left, bottom - top);
+
+    if (_textTexture && _textTexture->width() >= (unsigned)_textTextureSize.width() && _textTexture->height() >= (unsigned)_textTextureSize.height())
+    {
+        _textTexture->fill(0);
+    }
+    else
+    {
+        _textTexture = make_unique<Graphics::Texture>(_textTextureSize.width(), _textTextureSize.height());
+    }
 
-        for (auto& symbol : line)
+    // Every glyph is drawn over its own outline
+    static const int outlineOffsets[8][2] = {{0, -1}, {0, 1}, {-1, 0}, {-1, -1}, {-1, 1}, {1, 0}, {1, -1}, {1, 1}};
+    for (unsigned int i = 0; i != _lines.size(); ++i)
+    {
+        unsigned int end = i + 1 < _lines.size() ? _lines.at(i + 1).firstGlyph : _glyphs.size();
+        for (unsigned int j = _lines.at(i).firstGlyph; j != end; ++j)
         {
-            symbol.setX(symbol.x() + xOffset);
-            symbol.setY(symbol.y() + yOffset);
-            // outline symbols
-            if (_outlineColor != 0)
+            auto& glyph = _glyphs.at(j);
+            int x = glyph.x + offsets.at(i) - left;
+            int y = glyph.y - top;
+            if (outlineFont)
             {
-                _addOutlineSymbol(symbol, outlineFont,  0, -1);
-                _addOutlineSymbol(symbol, outlineFont,  0,  1);
-                _addOutlineSymbol(symbol, outlineFont, -1,  0);
-                _addOutlineSymbol(symbol, outlineFont, -1, -1);
-                _addOutlineSymbol(symbol, outlineFont, -1,  1);
-                _addOutlineSymbol(symbol, outlineFont,  1,  0);
-                _addOutlineSymbol(symbol, outlineFont,  1, -1);
-                _addOutlineSymbol(symbol, outlineFont,  1,  1);
+                for (auto& offset : outlineOffsets)
+                {
+                    outlineFont->copyGlyphTo(glyph.chr, _textTexture.get(), x + offset[0], y + offset[1]);
+                }
             }
-        
-            _symbols.push_back(symbol);
+            aFont->copyGlyphTo(glyph.chr, _textTexture.get(), x, y);
         }
     }
-    _changed = false;
-}
 
-void TextArea::_addOutlineSymbol(const TextSymbol& symb, Font* font, int32_t ofsX, int32_t ofsY)
-{
-    _symbols.emplace_back(symb.chr(), symb.x() + ofsX, symb.y() + ofsY);
-    _symbols.back().setFont(font);
-}
-
-std::string TextArea::text() const
-{
-    return _text;
-}
+    // Glyphs are blended onto transparent texture, so its colors are multiplied by alpha already
+    auto renderer = Game::getInstance()->renderer();
+    if (renderer->premultipliedAlpha())
+    {
+        _textTexture->setBlendMode(renderer->premultipliedBlendMode());
+        return;
+    }
 
-unsigned int TextArea::timestampCreated() const
-{
-    return _timestampCreated;
+    auto surface = _textTexture->sdlSurface();
+    for (int y = 0; y != _textTextureSize.height(); ++y)
+    {
+        auto row = (Uint32*)((unsigned char*)surface->pixels + y * surface->pitch);
+        for (int x = 0; x != _textTextureSize.width(); ++x)
+        {
+            Uint8 r, g, b, a;
+            SDL_GetRGBA(row[x], surface->format, &r, &g, &b, &a);
+            if (a == 0 || a == 0xFF) continue;
+            row[x] = SDL_MapRGBA(surface->format, std::min(r * 0xFF / a, 0xFF), std::min(g * 0xFF / a, 0xFF), std::min(b * 0xFF / a, 0xFF), a);
+        }
+    }
+    _textTexture->update();
 }
 
 void TextArea::render(bool eggTransparency)
 {
     if (_changed) _calculate();
+    if (_textTextureChanged) _generateTextTexture();
+    if (_glyphs.empty()) return;
 
-    auto pos = position();
-    for (auto& symbol : _symbols)
-    {
-        symbol.render(pos.x(), pos.y());
-    }
+    Game::getInstance()->renderer()->drawTexture(_textTexture.get(), position() + _textTextureOffset, Point(), _textTextureSize);
 }
 
 TextArea& TextArea::operator<<(const std::string& text)
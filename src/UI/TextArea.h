@@ -22,6 +22,7 @@
 
 // C++ standard includes
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -34,7 +35,6 @@ namespace Falltergeist
 {
 class Font;
 class FontString;
-class TextSymbol;
 
 namespace UI
 {
@@ -215,8 +215,38 @@ public:
     TextArea& operator=(signed value);
 
 protected:
+    /**
+     * Laid out glyph. Position is relative to text area, before line alignment.
+     */
+    struct Glyph
+    {
+        int32_t x;
+        int32_t y;
+        uint8_t chr;
+    };
+    struct Line
+    {
+        unsigned int firstGlyph;
+        unsigned int width;
+    };
+    /**
+     * Layout state at the start of each word, so layout can be resumed from any word.
+     */
+    struct Word
+    {
+        unsigned int position;
+        unsigned int x;
+        unsigned int lineWidth;
+        unsigned int line;
+        unsigned int firstGlyph;
+    };
+
     bool _changed = true;
-    std::vector<TextSymbol> _symbols;
+    // Text before this position is laid out already
+    unsigned int _changedFrom = 0;
+    std::vector<Glyph> _glyphs;
+    std::vector<Line> _lines;
+    std::vector<Word> _words;
     std::string _text;
     Font* _font = nullptr;
 
@@ -241,8 +271,25 @@ protected:
     unsigned int _outlineColor = 0;
     unsigned int _timestampCreated = 0;
 
+    /**
+     * Symbols drawn into one texture, so text is rendered with a single draw call.
+     * It is kept while it is large enough for new text.
+     */
+    std::unique_ptr<Graphics::Texture> _textTexture;
+    bool _textTextureChanged = true;
+    // Position of texture relative to text area (outline reaches beyond it) and size of its used part
+    Point _textTextureOffset;
+    Size _textTextureSize;
+
+    /**
+     * Marks text from given position on as changed. Anything affecting all lines changes it from 0.
+     */
+    void _invalidate(unsigned int position = 0);
+    /**
+     * Lays out changed text, starting from the word the first changed character belongs to.
+     */
     void _calculate();
-    void _addOutlineSymbol(const TextSymbol& symb, Font* font, int32_t ofsX, int32_t ofsY);
+    void _generateTextTexture();
 
 };
 
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Related headers
+#include "../UI/TileAtlas.h"
+
+// C++ standard includes
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+// Falltergeist includes
+#include "../Base/StlFeatures.h"
+#include "../Exception.h"
+#include "../Graphics/Texture.h"
+#include "../Logger.h"
+#include "../ResourceManager.h"
+
+// Third party includes
+#include <libfalltergeist/Exception.h>
+#include <libfalltergeist/Frm/File.h>
+#include <libfalltergeist/Lst/File.h>
+#include <libfalltergeist/Pal/File.h>
+#include <SDL.h>
+
+namespace Falltergeist
+{
+namespace UI
+{
+
+using namespace Base;
+using namespace libfalltergeist;
+
+const int TileAtlas::TILE_WIDTH = 80;
+const int TileAtlas::TILE_HEIGHT = 36;
+
+TileAtlas::TileAtlas()
+{
+}
+
+TileAtlas::~TileAtlas()
+{
+}
+
+void TileAtlas::add(unsigned int number)
+{
+    if (_texture) throw Exception("TileAtlas::add() - atlas is prepared already");
+    if (_indices.insert(std::make_pair(number, _numbers.size())).second)
+    {
+        _numbers.push_back(number);
+    }
+}
+
+unsigned int TileAtlas::index(unsigned int number) const
+{
+    return _indices.at(number);
+}
+
+Point TileAtlas::position(unsigned int index) const
+{
+    return Point((index % _square) * TILE_WIDTH, (index / _square) * TILE_HEIGHT);
+}
+
+void TileAtlas::prepare()
+{
+    if (_texture) return;
+
+    auto ticks = SDL_GetTicks();
+    _square = std::max(1u, (unsigned)std::ceil(std::sqrt(_numbers.size())));
+    _texture = make_unique<Graphics::Texture>(_square * TILE_WIDTH, _square * TILE_HEIGHT);
+
+    // Files are read on main thread, workers only convert or copy pixels. Different numbers may point to the same file
+    struct Job
+    {
+        Frm::File* frm = nullptr;
+        // Pixels pre-converted by falltergeist-packer, FRM is decoded only when pack has none
+        std::vector<char> packed;
+        unsigned int width = 0;
+        unsigned int height = 0;
+        std::vector<unsigned int> cells;
+    };
+    auto resourceManager = ResourceManager::getInstance();
+    auto palette = resourceManager->palFileType("color.pal");
+    auto tilesLst = resourceManager->lstFileType("art/tiles/tiles.lst");
+    std::vector<Job> jobs;
+    std::unordered_map<std::string, unsigned int> jobIndices;
+    for (unsigned int i = 0; i != _numbers.size(); ++i)
+    {
+        if (_numbers.at(i) >= tilesLst->strings()->size()) continue;
+        std::string filename = "art/tiles/" + tilesLst->strings()->at(_numbers.at(i));
+        std::transform(filename.begin(), filename.end(), filename.begin(), ::tolower);
+
+        auto it = jobIndices.find(filename);
+        if (it == jobIndices.end())
+        {
+            Job job;
+            if (!resourceManager->packedPixels(filename, job.packed, job.width, job.height))
+            {
+                job.frm = resourceManager->frmFileType(filename);
+                if (!job.frm) continue;
+                job.width = job.frm->width();
+                job.height = job.frm->height();
+            }
+            it = jobIndices.insert(std::make_pair(filename, jobs.size())).first;
+            jobs.push_back(std::move(job));
+        }
+        jobs.at(it->second).cells.push_back(i);
+    }
+
+    auto surface = _texture->sdlSurface();
+    if (SDL_MUSTLOCK(surface))
+    {
+        SDL_LockSurface(surface);
+    }
+
+    // Every job writes its own cells of atlas, so no locking is needed
+    std::atomic<unsigned int> next(0);
+    auto worker = [&]()
+    {
+        for (unsigned int index = next++; index < jobs.size(); index = next++)
+        {
+            auto& job = jobs.at(index);
+            const unsigned char* pixels = (const unsigned char*)job.packed.data() + 8;
+            if (job.frm)
+            {
+                try
+                {
+                    pixels = (const unsigned char*)job.frm->rgba(palette);
+                }
+                catch (const libfalltergeist::Exception& e)
+                {
+                    Logger::error("GAME") << "Tile " << job.frm->filename() << ": " << e.what() << std::endl;
+                    continue;
+                }
+            }
+
+            unsigned int width = std::min((int)job.width, TILE_WIDTH);
+            unsigned int height = std::min((int)job.height, TILE_HEIGHT);
+            for (auto cell : job.cells)
+            {
+                Point position = this->position(cell);
+                for (unsigned int y = 0; y != height; ++y)
+                {
+                    auto row = (unsigned char*)surface->pixels + (position.y() + y) * surface->pitch + position.x() * 4;
+                    std::memcpy(row, pixels + y * job.width * 4, width * 4);
+                }
+            }
+        }
+    };
+
+    unsigned int threads = std::min((unsigned int)jobs.size(), std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> pool;
+    for (unsigned int i = 1; i < threads; ++i)
+    {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool)
+    {
+        thread.join();
+    }
+
+    if (SDL_MUSTLOCK(surface))
+    {
+        SDL_UnlockSurface(surface);
+    }
+    _texture->update();
+
+    Logger::info("GAME") << "Tilemap generated in " << (SDL_GetTicks() - ticks) << " ms, " << _numbers.size() << " tiles, " << threads << " threads" << std::endl;
+}
+
+Graphics::Texture* TileAtlas::texture()
+{
+    prepare();
+    return _texture.get();
+}
+
+}
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FALLTERGEIST_UI_TILEATLAS_H
+#define FALLTERGEIST_UI_TILEATLAS_H
+
+// C++ standard includes
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Falltergeist includes
+#include "../Point.h"
+
+// Third party includes
+
+namespace Falltergeist
+{
+namespace Graphics
+{
+    class Texture;
+}
+namespace UI
+{
+
+/**
+ * Square texture with every distinct tile of a map, shared by floor and roof of all elevations.
+ */
+class TileAtlas
+{
+public:
+    static const int TILE_WIDTH;
+    static const int TILE_HEIGHT;
+
+    TileAtlas();
+    ~TileAtlas();
+
+    /**
+     * Adds tile to atlas unless it is there already. Tiles can be added before atlas is prepared only.
+     */
+    void add(unsigned int number);
+    unsigned int index(unsigned int number) const;
+    /**
+     * Top left corner of tile with given index in atlas texture.
+     */
+    Point position(unsigned int index) const;
+    /**
+     * Decodes tiles on all CPU cores and fills atlas if it is not done yet.
+     */
+    void prepare();
+    Graphics::Texture* texture();
+
+protected:
+    std::vector<unsigned int> _numbers;
+    std::unordered_map<unsigned int, unsigned int> _indices;
+    unsigned int _square = 0;
+    std::unique_ptr<Graphics::Texture> _texture;
+};
+
+}
+}
+#endif // FALLTERGEIST_UI_TILEATLAS_H
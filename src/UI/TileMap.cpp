@@ -30,11 +30,11 @@
 #include "../Graphics/Renderer.h"
 #include "../Graphics/Texture.h"
 #include "../LocationCamera.h"
-#include "../Logger.h"
 #include "../Point.h"
-#include "../ResourceManager.h"
+#include "../Profiler.h"
 #include "../State/Location.h"
 #include "../UI/Tile.h"
+#include "../UI/TileAtlas.h"
 
 // Thrird party includes
 
@@ -45,8 +45,16 @@ namespace UI
 
 using namespace Base;
 
-TileMap::TileMap()
+namespace
 {
+const Size TILE_SIZE = Size(TileAtlas::TILE_WIDTH, TileAtlas::TILE_HEIGHT);
+}
+
+const int TileMap::CHUNK_SIZE = 512;
+
+TileMap::TileMap(TileAtlas* atlas)
+{
+    _atlas = atlas;
 }
 
 TileMap::~TileMap()
@@ -58,67 +66,148 @@ std::vector<std::unique_ptr<Tile>>& TileMap::tiles()
     return _tiles;
 }
 
+void TileMap::prepare()
+{
+    if (_chunks.empty() && !_tiles.empty())
+    {
+        _atlas->prepare();
+        for (auto& tile : _tiles)
+        {
+            tile->setIndex(_atlas->index(tile->number()));
+        }
+        _generateChunks();
+    }
+}
+
 void TileMap::render()
 {
-    if (!_texture) _generateTexture();
+    FALLTERGEIST_PROFILE("TileMap::render");
+    prepare();
+    if (_chunks.empty()) return;
 
     auto camera = Game::getInstance()->locationState()->camera();
     auto renderer = Game::getInstance()->renderer();
 
-    for (auto& tile : _tiles)
+    // Chunks in view, rounded down towards the origin
+    Point topLeft = camera->topLeft() - _origin;
+    Point bottomRight = topLeft + Point(camera->size().width() - 1, camera->size().height() - 1);
+    int left = (int)std::floor((double)topLeft.x() / CHUNK_SIZE);
+    int top = (int)std::floor((double)topLeft.y() / CHUNK_SIZE);
+    int right = (int)std::floor((double)bottomRight.x() / CHUNK_SIZE);
+    int bottom = (int)std::floor((double)bottomRight.y() / CHUNK_SIZE);
+
+    // Chunks one step away from view are kept and built ahead, one per frame; farther ones are freed
+    bool builtAhead = false;
+    for (unsigned int i = 0; i != _chunks.size(); ++i)
     {
-        const Size tileSize = Size(80, 36);
-        if (Rect::intersects(tile->position(), tileSize, camera->topLeft(), camera->size()))
+        auto& chunk = _chunks.at(i);
+        int column = i % _columns;
+        int row = i / _columns;
+
+        if (column < left - 1 || column > right + 1 || row < top - 1 || row > bottom + 1)
+        {
+            chunk.texture.reset();
+            continue;
+        }
+        if (chunk.tiles.empty()) continue;
+
+        bool inView = column >= left && column <= right && row >= top && row <= bottom;
+        if (!chunk.texture)
         {
-            Point positionOnScreen = tile->position() - camera->topLeft();
-            Point square = Point(
-                (tile->index() % _square) * tileSize.width(),
-                (tile->index() / _square) * tileSize.height()
-            );
-            renderer->drawTexture(_texture.get(), positionOnScreen, square, tileSize);
+            if (!inView && builtAhead) continue;
+            _buildChunk(i);
+            if (!inView) builtAhead = true;
+        }
+
+        if (inView && chunk.visible)
+        {
+            Point position = _origin + Point(column * CHUNK_SIZE, row * CHUNK_SIZE) - camera->topLeft();
+            renderer->drawTexture(chunk.texture.get(), position);
         }
     }
 }
 
-void TileMap::_generateTexture()
+void TileMap::hideChunksAt(const Point& position)
 {
-    auto ticks = SDL_GetTicks();
-    std::vector<unsigned int> numbers;
-    for (auto& tile : _tiles)
+    for (auto& chunk : _chunks)
     {
-        auto position = std::find(numbers.begin(), numbers.end(), tile->number());
-        if ( position == numbers.end())
+        chunk.visible = true;
+    }
+
+    // Only the chunk the point lies in can have a tile over it
+    Point offset = position - _origin;
+    if (offset.x() < 0 || offset.y() < 0) return;
+    unsigned int column = offset.x() / CHUNK_SIZE;
+    unsigned int row = offset.y() / CHUNK_SIZE;
+    if (column >= _columns || row >= _rows) return;
+
+    auto& chunk = _chunks.at(row * _columns + column);
+    for (auto tile : chunk.tiles)
+    {
+        if (Rect::inRect(position, tile->position(), TILE_SIZE))
         {
-            tile->setIndex(numbers.size());
-            numbers.push_back(tile->number());
+            chunk.visible = false;
+            break;
         }
-        else
+    }
+}
+
+void TileMap::_generateChunks()
+{
+    Point min = _tiles.front()->position();
+    Point max = min;
+    for (auto& tile : _tiles)
+    {
+        min = Point(std::min(min.x(), tile->position().x()), std::min(min.y(), tile->position().y()));
+        max = Point(std::max(max.x(), tile->position().x()), std::max(max.y(), tile->position().y()));
+    }
+
+    _origin = min;
+    _columns = (max.x() + TILE_SIZE.width() - min.x() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    _rows = (max.y() + TILE_SIZE.height() - min.y() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    _chunks.clear();
+    _chunks.resize(_columns * _rows);
+
+    // Tile may lie across up to four chunks
+    for (auto& tile : _tiles)
+    {
+        Point position = tile->position() - _origin;
+        unsigned int left = position.x() / CHUNK_SIZE;
+        unsigned int top = position.y() / CHUNK_SIZE;
+        unsigned int right = (position.x() + TILE_SIZE.width() - 1) / CHUNK_SIZE;
+        unsigned int bottom = (position.y() + TILE_SIZE.height() - 1) / CHUNK_SIZE;
+        for (unsigned int row = top; row <= bottom; ++row)
         {
-            for (unsigned int i = 0; i != numbers.size(); ++i)
+            for (unsigned int column = left; column <= right; ++column)
             {
-                if (numbers.at(i) == tile->number())
-                {
-                    tile->setIndex(i);
-                    break;
-                }
+                _chunks.at(row * _columns + column).tiles.push_back(tile.get());
             }
         }
     }
+}
 
-    _square = (unsigned)std::ceil(std::sqrt(numbers.size()));
-
-    _texture = make_unique<Graphics::Texture>(_square*80, _square*36);
+void TileMap::_buildChunk(unsigned int index)
+{
+    auto& chunk = _chunks.at(index);
+    Point chunkPosition = _origin + Point((index % _columns) * CHUNK_SIZE, (index / _columns) * CHUNK_SIZE);
+    chunk.texture = make_unique<Graphics::Texture>(CHUNK_SIZE, CHUNK_SIZE);
 
-    auto tilesLst = ResourceManager::getInstance()->lstFileType("art/tiles/tiles.lst");
-    for (unsigned int i = 0; i != numbers.size(); ++i)
+    for (auto tile : chunk.tiles)
     {
-        auto texture = ResourceManager::getInstance()->texture("art/tiles/" + tilesLst->strings()->at(numbers.at(i)));
-        unsigned int x = (i%_square)*80;
-        unsigned int y = (i/_square)*36;
-        texture->copyTo(_texture.get(), x, y);
+        // Parts of tile outside of chunk are cut off
+        Point position = tile->position() - chunkPosition;
+        int sourceX = std::max(0, -position.x());
+        int sourceY = std::max(0, -position.y());
+        int destinationX = std::max(0, position.x());
+        int destinationY = std::max(0, position.y());
+        int width = std::min(TILE_SIZE.width() - sourceX, CHUNK_SIZE - destinationX);
+        int height = std::min(TILE_SIZE.height() - sourceY, CHUNK_SIZE - destinationY);
+        if (width <= 0 || height <= 0) continue;
+
+        Point source = _atlas->position(tile->index());
+        _atlas->texture()->copyTo(chunk.texture.get(), destinationX, destinationY,
+                                  source.x() + sourceX, source.y() + sourceY, width, height);
     }
-
-    Logger::info("GAME") << "Tilemap generated in " << (SDL_GetTicks() - ticks) << std::endl;
 }
 
 }
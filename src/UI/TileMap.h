@@ -25,6 +25,7 @@
 #include <memory>
 
 // Falltergeist includes
+#include "../Point.h"
 
 // Third party includes
 
@@ -38,21 +39,49 @@ namespace UI
 {
 
 class Tile;
+class TileAtlas;
 
+/**
+ * Tiles are pre-composited into square chunks of map, built around camera when they come into view.
+ */
 class TileMap
 {
 public:
-    TileMap();
+    static const int CHUNK_SIZE;
+
+    TileMap(TileAtlas* atlas);
     ~TileMap();
 
     std::vector<std::unique_ptr<Tile>>& tiles();
+    /**
+     * Prepares tile atlas and splits tiles into chunks if it is not done yet, otherwise it happens on first render.
+     */
+    void prepare();
     void render();
+    /**
+     * Hides chunk having a tile over given map point, all other chunks are shown.
+     */
+    void hideChunksAt(const Point& position);
 
 protected:
-    unsigned int _square = 0;
-    std::unique_ptr<Graphics::Texture> _texture = nullptr;
+    struct Chunk
+    {
+        std::unique_ptr<Graphics::Texture> texture;
+        // Tiles overlapping the chunk, in drawing order
+        std::vector<Tile*> tiles;
+        bool visible = true;
+    };
+
+    TileAtlas* _atlas = nullptr;
     std::vector<std::unique_ptr<Tile>> _tiles;
-    void _generateTexture();
+    // Top left corner of first chunk
+    Point _origin;
+    unsigned int _columns = 0;
+    unsigned int _rows = 0;
+    std::vector<Chunk> _chunks;
+
+    void _generateChunks();
+    void _buildChunk(unsigned int index);
 
 };
 
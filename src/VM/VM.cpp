@@ -27,6 +27,7 @@
 #include "../Game/Game.h"
 #include "../Game/Object.h"
 #include "../Logger.h"
+#include "../Profiler.h"
 #include "../ResourceManager.h"
 #include "../VM/OpcodeFactory.h"
 #include "../VM/VM.h"
@@ -96,6 +97,7 @@ void VM::initialize()
 
 void VM::run()
 {
+    FALLTERGEIST_PROFILE("VM::run");
     while (_programCounter != _script->size())
     {
         if (_programCounter == 0 && _initialized) return;
@@ -0,0 +1,458 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// C++ standard includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+    #include <sys/resource.h>
+#endif
+
+// Falltergeist includes
+#include "../../src/CrossPlatform.h"
+#include "../../src/Exception.h"
+#include "../../src/Ini/File.h"
+#include "../../src/Ini/Parser.h"
+#include "../../src/Logger.h"
+#include "../../src/Pack/File.h"
+#include "../../src/Pack/StreamBuffer.h"
+#include "../../src/ResourceManager.h"
+
+// Third party includes
+#include <libfalltergeist/Acm/File.h>
+#include <libfalltergeist/Dat/File.h>
+#include <libfalltergeist/Dat/Item.h>
+#include <libfalltergeist/Enums.h>
+#include <libfalltergeist/Exception.h>
+#include <libfalltergeist/Frm/File.h>
+#include <libfalltergeist/Int/File.h>
+#include <libfalltergeist/Lst/File.h>
+#include <libfalltergeist/Map/File.h>
+#include <libfalltergeist/Msg/File.h>
+#include <libfalltergeist/Pal/File.h>
+#include <libfalltergeist/Pro/File.h>
+
+namespace Falltergeist
+{
+
+using namespace libfalltergeist;
+
+namespace
+{
+
+struct Asset
+{
+    std::string type;
+    std::string filename;
+};
+
+struct Sample
+{
+    std::string type;
+    uint64_t bytes;
+    uint64_t time; // microseconds
+};
+
+uint64_t now()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Kilobytes
+long peakRss()
+{
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    #ifdef __APPLE__
+        return usage.ru_maxrss / 1024;
+    #else
+        return usage.ru_maxrss;
+    #endif
+#endif
+}
+
+std::string lowercase(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+    return value;
+}
+
+// Same lookup as ResourceManager constructor
+std::string findPack()
+{
+    for (auto path : {CrossPlatform::findFalltergeistDataPath(), CrossPlatform::findFalloutDataPath()})
+    {
+        std::ifstream stream(path + "/falltergeist.pak", std::ios_base::binary);
+        if (stream.is_open()) return path + "/falltergeist.pak";
+    }
+    return "";
+}
+
+/**
+ * Every worker opens its own pack and DAT files, libfalltergeist items are not safe to share between threads.
+ * Files are taken from the pack first, as the engine does.
+ */
+class Source
+{
+public:
+    Source(const std::string& packFilename)
+    {
+        if (!packFilename.empty())
+        {
+            _pack.reset(new Pack::File(packFilename));
+        }
+        for (auto& name : *CrossPlatform::findFalloutDataFiles())
+        {
+            _datFiles.push_back(std::unique_ptr<Dat::File>(new Dat::File(CrossPlatform::findFalloutDataPath() + "/" + name)));
+        }
+    }
+
+    Dat::Item* item(const std::string& filename)
+    {
+        if (_pack)
+        {
+            auto it = _packItems.find(filename);
+            if (it != _packItems.end()) return it->second.get();
+
+            if (auto entry = _pack->entry(filename))
+            {
+                Pack::StreamBuffer buffer(_pack->data(entry));
+                std::ifstream stream;
+                buffer.attach(stream);
+                std::unique_ptr<Dat::Item> item(ResourceManager::createItem(filename, &stream));
+                item->setFilename(filename);
+                auto result = item.get();
+                _packItems[filename] = std::move(item);
+                return result;
+            }
+        }
+
+        for (auto& datFile : _datFiles)
+        {
+            if (auto item = datFile->item(filename)) return item;
+        }
+        return nullptr;
+    }
+
+    // Pixels pre-converted by falltergeist-packer, ResourceManager::texture() takes them instead of decoding FRM
+    bool texture(const std::string& filename, uint64_t& bytes)
+    {
+        if (!_pack) return false;
+        auto entry = _pack->entry(filename + Pack::TEXTURE_SUFFIX);
+        if (!entry || entry->kind != Pack::KIND::TEXTURE) return false;
+        bytes = _pack->data(entry).size();
+        return true;
+    }
+
+    // Same lookup as ResourceManager::proFileType(unsigned int), maps need it while parsing
+    Pro::File* proFileType(unsigned int PID)
+    {
+        static const std::map<OBJECT_TYPE, std::string> directories = {
+            {OBJECT_TYPE::ITEM, "items"}, {OBJECT_TYPE::CRITTER, "critters"}, {OBJECT_TYPE::SCENERY, "scenery"},
+            {OBJECT_TYPE::WALL, "walls"}, {OBJECT_TYPE::TILE, "tiles"}, {OBJECT_TYPE::MISC, "misc"}
+        };
+        auto directory = directories.find((OBJECT_TYPE)(PID >> 24));
+        if (directory == directories.end()) return nullptr;
+
+        auto lst = dynamic_cast<Lst::File*>(item("proto/" + directory->second + "/" + directory->second + ".lst"));
+        unsigned int index = 0x00000FFF & PID;
+        if (!lst || index == 0 || index > lst->strings()->size()) return nullptr;
+        return dynamic_cast<Pro::File*>(item(lowercase("proto/" + directory->second + "/" + lst->strings()->at(index - 1))));
+    }
+
+    Pal::File* palette()
+    {
+        return dynamic_cast<Pal::File*>(item("color.pal"));
+    }
+
+protected:
+    std::unique_ptr<Pack::File> _pack;
+    std::map<std::string, std::unique_ptr<Dat::Item>> _packItems;
+    std::vector<std::unique_ptr<Dat::File>> _datFiles;
+};
+
+thread_local Source* currentSource = nullptr;
+
+Pro::File* fetchProFileType(unsigned int PID)
+{
+    return currentSource->proFileType(PID);
+}
+
+Pro::File* fetchResourceManagerProFileType(unsigned int PID)
+{
+    return ResourceManager::getInstance()->proFileType(PID);
+}
+
+// Does the work the engine does before a resource can be used
+void decodeItem(Dat::Item* item, Pal::File* palette, Pro::File* (*proFileType)(unsigned int))
+{
+    if (auto frm = dynamic_cast<Frm::File*>(item))
+    {
+        frm->rgba(palette);
+    }
+    else if (auto pro = dynamic_cast<Pro::File*>(item))
+    {
+        pro->PID();
+    }
+    else if (auto map = dynamic_cast<Map::File*>(item))
+    {
+        map->setCallback(proFileType);
+        map->elevations();
+    }
+    else if (auto script = dynamic_cast<Int::File*>(item))
+    {
+        script->procedures();
+    }
+    else if (auto msg = dynamic_cast<Msg::File*>(item))
+    {
+        msg->messages();
+    }
+    else if (auto acm = dynamic_cast<Acm::File*>(item))
+    {
+        acm->init();
+        std::vector<short> samples(acm->samples());
+        acm->readSamples(samples.data(), samples.size());
+    }
+}
+
+bool decode(Source& source, const Asset& asset, uint64_t& bytes)
+{
+    if (asset.type == "frm" && source.texture(asset.filename, bytes)) return true;
+
+    auto item = source.item(asset.filename);
+    if (!item) return false;
+    decodeItem(item, source.palette(), &fetchProFileType);
+    bytes = item->size();
+    return true;
+}
+
+std::vector<std::string> lstStrings(const std::string& filename)
+{
+    auto lst = ResourceManager::getInstance()->lstFileType(filename);
+    if (!lst) return std::vector<std::string>();
+    return *lst->strings();
+}
+
+std::vector<Asset> collectAssets()
+{
+    std::vector<Asset> assets;
+    std::set<std::string> filenames;
+    auto add = [&assets, &filenames](const std::string& type, const std::string& filename)
+    {
+        auto name = lowercase(filename);
+        if (filenames.insert(name).second) assets.push_back({type, name});
+    };
+
+    for (auto directory : {"items", "scenery", "walls", "tiles", "misc", "intrface", "inven"})
+    {
+        std::string prefix = std::string("art/") + directory + "/";
+        for (auto& name : lstStrings(prefix + directory + ".lst")) add("frm", prefix + name);
+    }
+    // Critter list holds base names only, stand animation exists for every critter
+    for (auto& name : lstStrings("art/critters/critters.lst")) add("frm", "art/critters/" + name.substr(0, 6) + "aa.frm");
+
+    for (auto directory : {"items", "critters", "scenery", "walls", "tiles", "misc"})
+    {
+        std::string prefix = std::string("proto/") + directory + "/";
+        for (auto& name : lstStrings(prefix + directory + ".lst")) add("pro", prefix + name);
+    }
+
+    for (auto& name : lstStrings("scripts/scripts.lst"))
+    {
+        add("int", "scripts/" + name);
+        add("msg", "text/english/dialog/" + name.substr(0, name.find('.')) + ".msg");
+    }
+
+    for (auto& name : lstStrings("sound/sfx/sndlist.lst"))
+    {
+        if (lowercase(name).find(".acm") != std::string::npos) add("acm", "sound/sfx/" + name);
+    }
+
+    // There is no LST for maps, maps.txt is the engine's list
+    std::istream stream(ResourceManager::getInstance()->datFileItem("data/maps.txt"));
+    auto ini = Ini::Parser(stream).parse();
+    for (auto section : *ini)
+    {
+        for (auto property : *section.second)
+        {
+            if (property.first == "map_name") add("map", "maps/" + property.second.value() + ".map");
+        }
+    }
+
+    return assets;
+}
+
+void report(const std::string& title, unsigned int threads, const std::vector<Sample>& samples, unsigned int missing, uint64_t wallTime)
+{
+    std::map<std::string, std::vector<uint64_t>> latencies;
+    std::map<std::string, uint64_t> bytes;
+    uint64_t totalBytes = 0;
+    for (auto& sample : samples)
+    {
+        latencies[sample.type].push_back(sample.time);
+        bytes[sample.type] += sample.bytes;
+        totalBytes += sample.bytes;
+    }
+
+    double seconds = wallTime / 1000000.0;
+    std::cout << std::fixed << std::setprecision(1)
+              << title << " (" << threads << " threads): "
+              << samples.size() << " files, " << missing << " missing, "
+              << seconds << " s, "
+              << samples.size() / seconds << " files/s, "
+              << totalBytes / 1048576.0 / seconds << " MB/s, "
+              << "peak RSS " << peakRss() / 1024 << " MB" << std::endl;
+
+    for (auto& type : latencies)
+    {
+        auto& times = type.second;
+        std::sort(times.begin(), times.end());
+        std::cout << "    " << type.first << ": "
+                  << times.size() << " files, "
+                  << bytes[type.first] / 1048576.0 << " MB, "
+                  << "p50 " << times[times.size() / 2] << " us, "
+                  << "p99 " << times[std::min(times.size() - 1, times.size() * 99 / 100)] << " us" << std::endl;
+    }
+}
+
+void run(const std::vector<Asset>& assets, unsigned int threads, const std::string& packFilename)
+{
+    std::atomic<unsigned int> next(0);
+    std::atomic<unsigned int> missing(0);
+    std::vector<std::vector<Sample>> results(threads);
+
+    auto worker = [&](unsigned int index)
+    {
+        Source source(packFilename);
+        currentSource = &source;
+        for (unsigned int i = next++; i < assets.size(); i = next++)
+        {
+            uint64_t bytes = 0;
+            uint64_t startTime = now();
+            if (decode(source, assets[i], bytes))
+            {
+                results[index].push_back({assets[i].type, bytes, now() - startTime});
+            }
+            else
+            {
+                missing++;
+            }
+        }
+        currentSource = nullptr;
+    };
+
+    uint64_t startTime = now();
+    std::vector<std::thread> pool;
+    for (unsigned int i = 0; i != threads; ++i)
+    {
+        pool.emplace_back(worker, i);
+    }
+    for (auto& thread : pool)
+    {
+        thread.join();
+    }
+    uint64_t wallTime = now() - startTime;
+
+    std::vector<Sample> samples;
+    for (auto& result : results)
+    {
+        samples.insert(samples.end(), result.begin(), result.end());
+    }
+    report(threads == 1 ? "single-threaded" : "multi-threaded", threads, samples, missing, wallTime);
+}
+
+/**
+ * Loads through ResourceManager lookup, cache and statistics on the main thread, as the game does.
+ * texture() needs a renderer, so FRM pixels are converted the way it does when there is no pack.
+ */
+void runResourceManager(const std::vector<Asset>& assets)
+{
+    auto resourceManager = ResourceManager::getInstance();
+    auto palette = resourceManager->palFileType("color.pal");
+    unsigned int missing = 0;
+    std::vector<Sample> samples;
+
+    uint64_t startTime = now();
+    for (auto& asset : assets)
+    {
+        uint64_t itemStartTime = now();
+        auto item = resourceManager->datFileItem(asset.filename);
+        if (!item)
+        {
+            missing++;
+            continue;
+        }
+        decodeItem(item, palette, &fetchResourceManagerProFileType);
+        samples.push_back({asset.type, item->size(), now() - itemStartTime});
+    }
+    report("resource manager", 1, samples, missing, now() - startTime);
+}
+
+}
+}
+
+using Falltergeist::Logger;
+
+// Usage: falltergeist-bench-assets [threads]
+int main(int argc, char* argv[])
+{
+    try
+    {
+        unsigned int threads = argc > 1 ? std::atoi(argv[1]) : std::thread::hardware_concurrency();
+        if (threads == 0) threads = 4;
+
+        Logger::setLevel(Logger::Level::LOG_WARNING);
+        auto assets = Falltergeist::collectAssets();
+        std::cout << assets.size() << " assets listed" << std::endl;
+
+        // Same sources the engine reads: pack first, then DAT files
+        auto pack = Falltergeist::findPack();
+        std::cout << (pack.empty() ? "no pack found, reading DAT files" : "pack: " + pack) << std::endl;
+
+        Falltergeist::run(assets, 1, pack);
+        Falltergeist::run(assets, threads, pack);
+        Falltergeist::runResourceManager(assets);
+        return 0;
+    }
+    catch(const libfalltergeist::Exception &e)
+    {
+        Logger::critical() << e.what() << std::endl;
+    }
+    catch(const Falltergeist::Exception &e)
+    {
+        Logger::critical() << e.what() << std::endl;
+    }
+    return 1;
+}
@@ -0,0 +1,296 @@
+/*
+ * Copyright 2012-2015 Falltergeist Developers.
+ *
+ * This file is part of Falltergeist.
+ *
+ * Falltergeist is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Falltergeist is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Falltergeist.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// C++ standard includes
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+
+// Falltergeist includes
+#include "../../src/CrossPlatform.h"
+#include "../../src/Exception.h"
+#include "../../src/Logger.h"
+#include "../../src/Pack/StreamBuffer.h"
+#include "../../src/Pack/Writer.h"
+
+// Third party includes
+#include <libfalltergeist/Dat/File.h>
+#include <libfalltergeist/Dat/Item.h>
+#include <libfalltergeist/Exception.h>
+#include <libfalltergeist/Frm/File.h>
+#include <libfalltergeist/Pal/File.h>
+#include <libfalltergeist/Rix/File.h>
+#include <SDL_image.h>
+
+namespace Falltergeist
+{
+
+using namespace libfalltergeist;
+
+namespace
+{
+
+// Same naming as ResourceManager::datFileItem() uses for lookups
+std::string normalize(std::string name)
+{
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    std::replace(name.begin(), name.end(), '\\', '/');
+    return name;
+}
+
+std::string extension(const std::string& name)
+{
+    auto position = name.rfind('.');
+    return position == std::string::npos ? "" : name.substr(position);
+}
+
+// Recursive listing, sorted so that repeated runs produce identical packs
+void listDirectory(const std::string& root, const std::string& prefix, std::vector<std::string>& files)
+{
+    DIR* directory = opendir((root + "/" + prefix).c_str());
+    if (!directory) return;
+
+    std::vector<std::string> names;
+    while (dirent* entry = readdir(directory))
+    {
+        std::string name = entry->d_name;
+        if (name != "." && name != "..") names.push_back(name);
+    }
+    closedir(directory);
+    std::sort(names.begin(), names.end());
+
+    for (auto& name : names)
+    {
+        std::string path = prefix.empty() ? name : prefix + "/" + name;
+        struct stat info;
+        if (stat((root + "/" + path).c_str(), &info) != 0) continue;
+
+        if (S_ISDIR(info.st_mode))
+        {
+            listDirectory(root, path, files);
+        }
+        else if (S_ISREG(info.st_mode))
+        {
+            files.push_back(path);
+        }
+    }
+}
+
+std::vector<char> readFile(const std::string& path)
+{
+    std::ifstream stream(path, std::ios_base::binary);
+    if (!stream.is_open())
+    {
+        throw Exception("packer - can't open file: " + path);
+    }
+    return std::vector<char>((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+}
+
+std::vector<char> readItem(Dat::Item* item)
+{
+    std::vector<char> data(item->size());
+    item->setPosition(0);
+    if (!data.empty())
+    {
+        item->readBytes(data.data(), data.size());
+    }
+    return data;
+}
+
+template <class T>
+std::unique_ptr<T> parse(std::vector<char> data)
+{
+    Pack::StreamBuffer buffer(std::move(data));
+    std::ifstream stream;
+    buffer.attach(stream);
+    return std::unique_ptr<T>(new T(&stream));
+}
+
+std::vector<char> texture(unsigned int width, unsigned int height, const unsigned int* rgba, unsigned int pitch)
+{
+    std::vector<char> data(8 + width * height * 4);
+    Pack::writeUInt32((unsigned char*)data.data(), width);
+    Pack::writeUInt32((unsigned char*)data.data() + 4, height);
+    for (unsigned int y = 0; y != height; ++y)
+    {
+        memcpy(data.data() + 8 + y * width * 4, (const char*)rgba + y * pitch, width * 4);
+    }
+    return data;
+}
+
+class Packer
+{
+public:
+    Packer(const std::string& filename) : _writer(filename)
+    {
+        for (auto& name : *CrossPlatform::findFalloutDataFiles())
+        {
+            _datFiles.push_back(std::unique_ptr<Dat::File>(new Dat::File(CrossPlatform::findFalloutDataPath() + "/" + name)));
+        }
+    }
+
+    void run()
+    {
+        _loadPalette();
+
+        // Same precedence as ResourceManager::datFileItem(): loose files in Fallout data directory,
+        // then falltergeist data directory, then DAT files
+        std::string falloutRoot = CrossPlatform::findFalloutDataPath();
+        std::vector<std::string> falloutFiles;
+        listDirectory(falloutRoot, "", falloutFiles);
+        for (auto& path : falloutFiles)
+        {
+            // Archives themselves, packs and unfinished packs are no game files
+            std::string ext = extension(normalize(path));
+            if (ext == ".dat" || ext == ".pak" || ext == ".tmp") continue;
+            _add(normalize(path), readFile(falloutRoot + "/" + path), falloutRoot + "/" + path);
+        }
+
+        std::string root = CrossPlatform::findFalltergeistDataPath();
+        std::vector<std::string> files;
+        listDirectory(root, "data", files);
+        for (auto& path : files)
+        {
+            _add(normalize(path), readFile(root + "/" + path), root + "/" + path);
+        }
+
+        for (auto& datFile : _datFiles)
+        {
+            Logger::info("PACKER") << "Packing " << datFile->filename() << std::endl;
+            for (auto item : *datFile->items())
+            {
+                _add(normalize(item->filename()), readItem(item), "");
+            }
+        }
+
+        _writer.finish();
+        Logger::info("PACKER") << _writer.size() << " entries, " << _writer.bytesWritten() << " bytes" << std::endl;
+    }
+
+protected:
+    Pack::Writer _writer;
+    std::vector<std::unique_ptr<Dat::File>> _datFiles;
+    std::unique_ptr<Pal::File> _palette;
+
+    // Found the same way as the game finds it, so textures are converted with the palette it uses
+    void _loadPalette()
+    {
+        for (auto root : {CrossPlatform::findFalloutDataPath(), CrossPlatform::findFalltergeistDataPath()})
+        {
+            std::ifstream stream(root + "/color.pal", std::ios_base::binary);
+            if (!stream.is_open()) continue;
+            _palette = parse<Pal::File>(readFile(root + "/color.pal"));
+            return;
+        }
+        for (auto& datFile : _datFiles)
+        {
+            if (auto item = datFile->item("color.pal"))
+            {
+                _palette = parse<Pal::File>(readItem(item));
+                return;
+            }
+        }
+        throw Exception("packer - color.pal not found");
+    }
+
+    void _add(const std::string& name, std::vector<char> data, const std::string& path)
+    {
+        if (_writer.contains(name)) return;
+
+        // Same textures as ResourceManager::texture() would build at run time
+        std::vector<char> rgba;
+        std::string ext = extension(name);
+        if (ext == ".frm")
+        {
+            auto frm = parse<Frm::File>(data);
+            rgba = texture(frm->width(), frm->height(), frm->rgba(_palette.get()), frm->width() * 4);
+        }
+        else if (ext == ".rix")
+        {
+            auto rix = parse<Rix::File>(data);
+            rgba = texture(rix->width(), rix->height(), rix->rgba(), rix->width() * 4);
+        }
+        else if (ext == ".png" && !path.empty())
+        {
+            SDL_Surface* surface = IMG_Load(path.c_str());
+            if (!surface)
+            {
+                throw Exception("packer - can't load image " + path + ": " + IMG_GetError());
+            }
+            SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA8888, 0);
+            SDL_FreeSurface(surface);
+            if (!converted)
+            {
+                throw Exception("packer - can't convert image " + path + ": " + SDL_GetError());
+            }
+            rgba = texture(converted->w, converted->h, (unsigned int*)converted->pixels, converted->pitch);
+            SDL_FreeSurface(converted);
+        }
+
+        _writer.add(name, data);
+        if (!rgba.empty())
+        {
+            _writer.add(name + Pack::TEXTURE_SUFFIX, rgba, Pack::KIND::TEXTURE);
+        }
+    }
+};
+
+}
+}
+
+using Falltergeist::CrossPlatform;
+using Falltergeist::Logger;
+
+int main(int argc, char* argv[])
+{
+    std::string filename = argc > 1 ? argv[1] : CrossPlatform::findFalloutDataPath() + "/falltergeist.pak";
+
+    try
+    {
+        // Written next to the target first, so a failed run never leaves a broken pack behind
+        {
+            Falltergeist::Packer packer(filename + ".tmp");
+            packer.run();
+        }
+        std::remove(filename.c_str());
+        if (std::rename((filename + ".tmp").c_str(), filename.c_str()) != 0)
+        {
+            throw Falltergeist::Exception("packer - can't rename pack to " + filename);
+        }
+        Logger::info("PACKER") << "Pack written to " << filename << std::endl;
+        return 0;
+    }
+    catch(const libfalltergeist::Exception &e)
+    {
+        Logger::critical() << e.what() << std::endl;
+    }
+    catch(const Falltergeist::Exception &e)
+    {
+        Logger::critical() << e.what() << std::endl;
+    }
+    std::remove((filename + ".tmp").c_str());
+    return 1;
+}
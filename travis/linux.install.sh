@@ -9,6 +9,7 @@ sudo apt-get install -qq libsdl2-dev
 sudo apt-get install -qq libsdl2-mixer-dev
 sudo apt-get install -qq libsdl2-image-dev
 sudo apt-get install -qq liblua5.1-dev
+sudo apt-get install -qq zlib1g-dev
 
 if [ "$CXX" = "clang++" ]; then sudo apt-get install -qq libstdc++-4.8-dev; fi
 if [ "$CXX" = "g++" ]; then sudo apt-get install -qq g++-4.8; fi